@@ -23,9 +23,10 @@ class AnimationChannel {
 public:
 	void loadChannelData(tinygltf::Model const& model, tinygltf::Animation const& anim, tinygltf::AnimationChannel const& channel);
 
-	glm::vec3 getScaling(float time) const;
-	glm::vec3 getTranslation(float time) const;
-	glm::quat getRotation(float time) const;
+	// keyCursor is optional, it holds the last keyframe index used by the caller and is updated on return
+	glm::vec3 getScaling(float time, std::size_t* keyCursor = nullptr) const;
+	glm::vec3 getTranslation(float time, std::size_t* keyCursor = nullptr) const;
+	glm::quat getRotation(float time, std::size_t* keyCursor = nullptr) const;
 	float getMaxTime() const;
 
 	int targetNode{-1};
@@ -40,4 +41,6 @@ private:
 	std::vector<glm::vec3> scalings_{};
 	std::vector<glm::vec3> translations_{};
 	std::vector<glm::quat> rotations_{};
+
+	std::size_t findNextKeyframe_(float time, std::size_t* keyCursor) const;
 };
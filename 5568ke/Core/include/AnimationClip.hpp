@@ -2,9 +2,13 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include "AnimationTypes.hpp"
 
 // Forward declarations
 namespace tinygltf {
@@ -24,11 +28,41 @@ public:
 	AnimationClip(std::string const& name);
 
 	void addChannel(tinygltf::Model const& model, tinygltf::Animation const& anim, tinygltf::AnimationChannel const& channel);
-	void setAnimationFrame(std::vector<std::shared_ptr<Node>> const& nodes, float time);
+	// Writes the pose into the nodes' TRS, Model::updateLocalMatrices then rebuilds the matrices
+	// The cursor is optional, pass the same one every frame of a playback to skip the keyframe searches
+	void setAnimationFrame(std::vector<std::shared_ptr<Node>> const& nodes, float time, AnimationCursor* cursor = nullptr);
 	float getDuration() const;
+	// Same pose written into a Pose indexed by node index, nodes the clip doesn't animate keep their value
+	void samplePose(Pose& pose, float time, AnimationCursor* cursor = nullptr) const;
+
+	// Resample every channel at a uniform rate into one pose track, setAnimationFrame then reads the track instead of the channels
+	void bake(std::vector<std::shared_ptr<Node>> const& nodes, float sampleRate);
+	bool isBaked() const { return baked_.frameCount > 0; }
 
 	std::string clipName;
 
+	/**
+	 * @brief Structure of arrays pose track, frame major: the T/R/S of all animated nodes of frame f are contiguous.
+	 * Nodes without a channel for some path keep their rest value in that path.
+	 */
+	struct BakedTrack {
+		float duration{};
+		float sampleRate{}; // Frames per second, adjusted so that the last frame lands exactly on the duration
+		std::size_t frameCount{};
+		std::vector<int> nodeIndices; // Node animated by each slot
+		std::vector<glm::vec3> translations;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::vec3> scales;
+	};
+
+	// A clip restored from the binary model cache has only its baked track
+	BakedTrack const& getBakedTrack() const { return baked_; }
+	void setBakedTrack(BakedTrack track) { baked_ = std::move(track); }
+
 private:
 	std::vector<std::shared_ptr<AnimationChannel>> channels_{};
+	BakedTrack baked_;
+
+	void applyChannels_(std::vector<std::shared_ptr<Node>> const& nodes, float time, AnimationCursor* cursor) const;
+	void sampleBaked_(std::vector<std::shared_ptr<Node>> const& nodes, float time) const;
 };
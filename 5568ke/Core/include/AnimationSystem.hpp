@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AnimationTypes.hpp"
+
+class Model;
+class PoseBlender;
+class Scene;
+
+/**
+ * @brief Evaluates the poses of every model in the scene once per frame, spread over the ThreadPool.
+ *
+ * Gameplay code queues the clip pose of a model with play() instead of applying it on the spot. update() then hands
+ * each model to one thread, which samples the queued clip into the node TRS and runs the dirty pose stages
+ * (local TRS -> global -> joints -> bounds) into the matrices the model owns, which the renderer reads.
+ * A model only touches its own nodes and matrices and the shared asset is read only, so models need no locking.
+ * Moving the world boxes in the spatial index is not thread safe and runs on the calling thread afterwards.
+ * Requests are kept in Model::animationSlot and the job list reuses its storage, so a frame allocates nothing.
+ */
+class AnimationSystem {
+public:
+	static AnimationSystem& getInstance()
+	{
+		static AnimationSystem instance;
+		return instance;
+	}
+
+	// Models handed to a thread at a time, a few so a chunk outweighs the scheduling
+	static constexpr std::size_t k_modelsPerChunk = 4;
+
+	// Evaluate on the calling thread only, to compare
+	bool parallel{true};
+
+	// Sample this clip into the model at the next update, the last request of the frame wins.
+	// The cursor must stay alive until then, it is only used by the thread evaluating that model
+	void play(Model& model, int clipIndex, float time, AnimationCursor* cursor = nullptr);
+	// Blend the clips of the blender into the model at the next update instead, the blender must stay alive until then
+	void play(Model& model, PoseBlender& blender);
+
+	// Apply the queued clips and update the pose of every model of the scene, then refresh the world boxes that moved
+	void update(Scene& scene);
+
+	// Work done by the last update
+	struct Stats {
+		int models{};					 // Evaluated, one per distinct Model
+		int sampledClips{};		 // Queued clips applied
+		int blendedModels{};	 // Queued blenders applied
+		int localPasses{};
+		int globalPasses{};
+		int jointPasses{};
+		int boundsPasses{};
+		int cleanModels{};		 // Models left untouched since their pose did not change
+		int threads{};				 // Workers that could help, plus the calling thread
+		float milliseconds{}; // Wall time of the evaluation
+	};
+	Stats const& getStats() const { return stats_; }
+
+private:
+	AnimationSystem() = default;
+
+	// One entry per distinct model of the scene, rebuilt every update into the same storage.
+	// The queued request lives in Model::animationSlot, tagged with frame_
+	struct Job {
+		Model* model;
+		bool requested;
+		unsigned stages;
+	};
+	std::vector<Job> jobs_;
+	std::uint64_t frame_{0}; // Number of the next update
+
+	Stats stats_;
+};
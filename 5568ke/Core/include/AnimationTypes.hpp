@@ -1,4 +1,36 @@
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
 enum class InterpolationType { STEP, LINEAR, CUBICSPLINE };
 enum class TargetPath { ROTATION, TRANSLATION, SCALE };
+
+/**
+ * @brief Per-playback keyframe cursor, one entry per channel of the played clip.
+ * Holds the last key used by each channel, so playback moving forward finds the next keys without searching.
+ */
+struct AnimationCursor {
+	std::vector<std::size_t> keys;
+};
+
+/**
+ * @brief Local TRS of every node of a model, structure of arrays indexed by node index.
+ * Scratch buffer of the PoseBlender, sized once per model so sampling and blending don't allocate.
+ */
+struct Pose {
+	std::vector<glm::vec3> translations;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+
+	std::size_t size() const { return translations.size(); }
+	void resize(std::size_t nodeCount)
+	{
+		translations.resize(nodeCount);
+		rotations.resize(nodeCount);
+		scales.resize(nodeCount);
+	}
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -37,6 +38,7 @@ private:
 	void initImGui_();
 	// Scene setup methods
 	void setupDefaultScene_();
+	void onDefaultSceneLoaded_();
 	void addInvisibleWalls_();
 
 	// Main loop methods
@@ -64,6 +66,11 @@ private:
 	bool showStatsWindow_{true};
 	bool showSceneControlsWindow_{true};
 
+	// Default scene models still loading, and the objects handed to the dialog system once they are all in
+	int pendingSceneModels_{0};
+	std::shared_ptr<GameObject> teacherGO_;
+	std::array<std::shared_ptr<GameObject>, 3> routeGOs_{}; // Routes A, B and C
+
 	// Key state tracking
 	std::array<bool, 1024> keys_{};
 };
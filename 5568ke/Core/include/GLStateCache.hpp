@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+/**
+ * @brief Shadow copy of the GL state touched per draw: bound program, active unit, 2D texture per unit and
+ * sampler uniforms per program. Calls matching the shadow copy are skipped.
+ *
+ * Code binding these states directly (texture upload, ImGui backend) makes the copy stale, so it is
+ * invalidated at the start of every frame by the Renderer, after which the next call of each kind goes to GL.
+ */
+class GLStateCache {
+public:
+	static GLStateCache& getInstance()
+	{
+		static GLStateCache instance;
+		return instance;
+	}
+
+	static constexpr int k_maxTextureUnits = 16;
+
+	// Each returns true when a GL call was issued
+	bool useProgram(unsigned int program);
+	bool activeTexture(unsigned int unit);
+	bool bindTexture2D(unsigned int unit, unsigned int texture);
+	bool setSampler(unsigned int program, int location, int unit); // Program must be bound
+
+	// Forget everything, the next call of each kind reaches GL
+	void invalidate();
+	// Drop the state of a program about to be deleted
+	void forgetProgram(unsigned int program);
+
+	struct Stats {
+		int issued{};
+		int skipped{};
+	};
+	Stats const& getStats() const { return stats_; }
+	void resetStats() { stats_ = Stats(); }
+
+private:
+	GLStateCache() { invalidate(); }
+
+	static constexpr unsigned int k_unknown = ~0u;
+
+	unsigned int program_{k_unknown};
+	unsigned int activeUnit_{k_unknown};
+	std::array<unsigned int, k_maxTextureUnits> textures2D_{};
+	std::unordered_map<std::uint64_t, int> samplerUnits_; // (program << 32 | location) -> unit
+
+	Stats stats_;
+
+	bool track_(bool changed);
+};
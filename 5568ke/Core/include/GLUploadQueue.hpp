@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief GL work produced by the loader threads (buffer and texture uploads, load completion callbacks),
+ * run on the thread owning the GL context.
+ *
+ * Jobs run in the order they were pushed, so a job queued after the uploads of a model sees them done.
+ * drain runs jobs until the per-frame time budget is spent, at least one per call so the queue always advances.
+ */
+class GLUploadQueue {
+public:
+	static GLUploadQueue& getInstance()
+	{
+		static GLUploadQueue instance;
+		return instance;
+	}
+
+	// Call once from the thread owning the GL context, after the context is made current
+	void setGLThread() { glThread_ = std::this_thread::get_id(); }
+	bool isGLThread() const { return std::this_thread::get_id() == glThread_; }
+
+	// Thread safe
+	void push(std::function<void()> job);
+
+	// GL thread only, return the number of jobs run
+	std::size_t drain(double budgetMs);
+	std::size_t drainAll();
+
+	// Drop the queued jobs without running them
+	void clear();
+
+	std::size_t getPendingCount();
+
+private:
+	GLUploadQueue() = default;
+
+	std::deque<std::function<void()>> jobs_;
+	std::mutex mutex_;
+	std::thread::id glThread_;
+
+	bool popJob_(std::function<void()>& job);
+};
@@ -12,7 +12,9 @@
 #include <glm/mat4x4.hpp>
 
 #include "BoundingBox.hpp"
+#include "Frustum.hpp"
 
+class DynamicAABBTree;
 class Model;
 
 /**
@@ -60,7 +62,12 @@ public:
 	glm::vec3 directionTo(GameObject const& other) const;
 
 	// Bounds and collision
-	bool isInFrustum(glm::mat4 const& viewProjectionMatrix) const;
+	// Plane test of worldBBox, objects without a model are never visible
+	bool isInFrustum(Frustum const& frustum) const;
+
+	// Spatial index registration, worldBBox changes are forwarded to the tree by updateTransformMatrix
+	void attachSpatialIndex(DynamicAABBTree* tree, int proxyId);
+	int getSpatialProxy() const { return spatialProxy_; }
 
 	// Debug and utility
 	void printInfo() const;
@@ -70,7 +77,7 @@ public:
 	// Public properties that don't need additional logic
 	std::string_view name;
 	std::string tag;
-	bool visible{true};
+	bool visible{true}; // Change through Scene::setVisible once the object is in the scene
 	bool active{true};
 	int layer{0};
 
@@ -95,6 +102,9 @@ private:
 	std::shared_ptr<Model> model_{nullptr};
 	glm::mat4 transform_{1.0f};
 
+	DynamicAABBTree* spatialIndex_{nullptr};
+	int spatialProxy_{-1};
+
 	// Internal helper methods
 	glm::mat4 calculateTransformMatrix_() const;
 };
@@ -2,6 +2,9 @@
 
 #include <string>
 
+#include "AnimationTypes.hpp"
+#include "PoseBlender.hpp"
+
 class GlobalAnimationState {
 public:
 	static GlobalAnimationState& getInstance()
@@ -15,11 +18,14 @@ public:
 	std::string gameObjectName;
 	int clipIndex{1};
 	float currentTime{};
+	AnimationCursor cursor; // Keyframe cursor of the clip being played
 	float camSpeed{3.0f};
 
 	// Character movement state
 	bool characterMoveMode{false};
 	bool wasMoving{false};
+	PoseBlender blender;						// Walk / idle blending of the character
+	float crossfadeDuration{0.25f}; // Seconds from walk to idle and back
 	float followDistance{3.0f};
 	float followHeight{1.0f};
 
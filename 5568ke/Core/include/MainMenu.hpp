@@ -20,6 +20,9 @@ public:
     // Returns true if game should exit
     bool shouldExit() const { return exitGame_; }
 
+    // Number of models still loading in the background, shown under the buttons
+    void setPendingLoads(int count) { pendingLoads_ = count; }
+
 private:
     MainMenu() = default;
     ~MainMenu() = default;
@@ -30,4 +33,5 @@ private:
     bool startGame_ = false;
     bool exitGame_ = false;
     bool showInstructions_ = false;
+    int pendingLoads_ = 0;
 };
\ No newline at end of file
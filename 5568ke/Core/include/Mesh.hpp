@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "Primitive.hpp"
@@ -41,9 +43,15 @@ public:
 	 */
 	std::vector<Primitive> primitives;
 
+	// Post-transform vertex cache misses per triangle of the file order and of the current order (see MeshOptimizer), 0 when unknown
+	float acmrSource{0.0f};
+	float acmr{0.0f};
+
 	/**
 	 * @brief Initializes OpenGL buffers (VAO, VBO, EBO) and uploads vertex/index data.
-	 * Also configures vertex attribute pointers.
+	 * The vertices are packed into the compact GPU layout (StaticVertex, or SkinnedVertex when the mesh has bone weights)
+	 * and the vertex attribute pointers are configured for it.
+	 * The index buffer is uploaded as 16 bit when every vertex can be addressed with it.
 	 */
 	void setup();
 
@@ -55,7 +63,20 @@ public:
 	 */
 	void draw(Shader const& shader) const;
 
+	// Vertex array holding the vertex layout and the index buffer, used by the render queue to sort and skip rebinds
+	unsigned int getVAO() const { return vao_; }
+
+	// Layout of the uploaded vertex buffer, known once setup ran
+	VertexLayout getLayout() const { return layout_; }
+
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, and the byte size of one index in the uploaded buffer
+	unsigned int getIndexType() const;
+	std::size_t getIndexSize() const { return shortIndices_ ? sizeof(std::uint16_t) : sizeof(std::uint32_t); }
+
 private:
+	VertexLayout layout_{VertexLayout::Static};
+	bool shortIndices_{false};
+
 	// OpenGL object handles
 	unsigned int vao_{}; // Vertex Array Object
 	unsigned int vbo_{}; // Vertex Buffer Object (vertex data)
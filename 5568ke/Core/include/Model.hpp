@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <iostream>
@@ -8,40 +10,121 @@
 #include <string>
 #include <vector>
 
+#include "AnimationTypes.hpp"
 #include "BoundingBox.hpp"
 
 class AnimationClip;
 class Mesh;
 class Node;
+class PoseBlender;
 class Shader;
+class Texture;
 
+/**
+ * @brief Data loaded once per file and shared by every Model instance of it: GPU meshes, textures, clips and skin.
+ * Read only once the loader is done with it.
+ */
+struct ModelAsset {
+	std::string sourcePath;
+
+	// Core model data
+	std::vector<Mesh> meshes;
+	std::vector<int> meshNodeIndices; // Mesh -> Node mapping
+	std::vector<std::shared_ptr<Texture>> textures; // Shared through TextureCache, the materials point into these
+	std::vector<BoundingBox> boundingBoxes;
+
+	// Animation clips, they only write the TRS of the nodes handed to them
+	std::vector<std::shared_ptr<AnimationClip>> animations;
+
+	// Flattened node tree used for the matrix passes, nodeOrder lists node indices with parents before their children
+	std::vector<int> nodeOrder;
+	std::vector<int> nodeOrderParents; // Parent node index of each nodeOrder entry, -1 for the root
+
+	// Skinning data, the joints of every skin share one palette and the vertex bone ids index it
+	std::vector<glm::mat4> inverseBindMatrices; // Per palette joint
+	std::vector<int> jointNodes;								// Node index of each palette joint
+	std::vector<int> skinJointOffsets;					// First palette joint of each glTF skin
+
+	// Bind pose bounds in mesh space of the vertices weighted to each joint, and of the vertices weighted to none
+	// An empty box has min > max. Skinned bounds are the union of these boxes moved by the joint matrices (see BBoxUtil::updateLocalBBox)
+	std::vector<BoundingBox> jointBindBBoxes;
+	BoundingBox unskinnedBindBBox;
+
+	// Whether the upload jobs queued by the loader ran, every mesh has its VAO and every texture its GL id
+	bool isResident() const;
+};
+
+/**
+ * @brief One posable instance of a ModelAsset, owns the node TRS and the matrices computed from them.
+ * Instances of the same asset animate independently while sharing the GPU data.
+ */
 class Model {
 public:
 	Model() = default;
 	~Model();
 	void cleanup();
 
+	// New instance sharing the asset, the nodes start with the pose of this one
+	std::shared_ptr<Model> createInstance() const;
+
+	// Draw in the bind pose, animated skinned draws go through the RenderQueue, which uploads the joint palettes
 	void draw(Shader const& shader, glm::mat4 const& modelMatrix) const;
+
+	// Pose pipeline stages, each one depends on the previous
+	enum PoseStage : unsigned { POSE_LOCAL = 1u << 0, POSE_GLOBAL = 1u << 1, POSE_JOINTS = 1u << 2, POSE_BOUNDS = 1u << 3, POSE_ALL = 0xFu };
+
+	// Apply a clip pose to the nodes, nothing happens when that clip and time are already applied
+	void applyAnimationFrame(int clipIndex, float time, AnimationCursor* cursor = nullptr);
+	// Call after changing the TRS of a node directly
+	void markPoseDirty();
+	// Run the dirty stages once (local TRS -> global -> joints -> bounds), returns the stages that ran
+	unsigned updatePose();
+	// Force a full update of every stage
 	void updateLocalMatrices();
 
+	// Skin with dual quaternions instead of linear blend skinning, which keeps the volume of twisting elbows and wrists.
+	// Only the rotation and translation of each joint are kept, models with scaled joints should stay on linear blend
+	void setDualQuaternionSkinning(bool enabled);
+	bool usesDualQuaternionSkinning() const { return dualQuaternionSkinning_; }
+
 public:
-	// Core model data
-	std::vector<Mesh> meshes;
-	std::vector<int> meshNodeIndices; // Mesh -> Node mapping
-	std::vector<BoundingBox> boundingBoxes;
+	// Shared data, never null for a loaded model
+	std::shared_ptr<ModelAsset> asset;
+
 	BoundingBox localSpaceBBox;
 
 	// Metadata
 	std::string modelName;
 
-	// Animation support
-	std::vector<std::shared_ptr<AnimationClip>> animations;
+	// Node tree of this instance
 	std::vector<std::shared_ptr<Node>> nodes; // node list
 	std::shared_ptr<Node> rootNode;						// used to represent the node tree
 
-	// Skinning data
-	std::vector<glm::mat4> inverseBindMatrices;
-	std::vector<glm::mat4> jointMatrices;
-	std::vector<int> nodeToJointMapping;
-	std::vector<std::vector<std::pair<int, float>>> vertexJoints; // For each vertex: pairs of (jointIndex, weight)
+	// Matrices of this instance's pose
+	std::vector<glm::mat4> localMatrices;	 // Indexed by node index
+	std::vector<glm::mat4> globalMatrices; // Indexed by node index, in model space
+	glm::mat4 const& getNodeMatrix(int nodeIndex) const { return globalMatrices[nodeIndex]; }
+	std::vector<glm::mat4> jointMatrices; // Indexed by palette joint
+	// Same joints as unit dual quaternions, only filled while dual quaternion skinning is on
+	// Columns are the real and dual part as (x, y, z, w), 8 floats per joint instead of 16
+	std::vector<glm::mat2x4> jointDualQuaternions;
+
+	// Written by AnimationSystem only: the clip or blender queued for its next update, and the job of this model in it.
+	// Each field is tagged with the update it belongs to, so nothing has to be cleared between frames
+	struct AnimationSlot {
+		std::uint64_t requestFrame{~0ull};
+		int clipIndex{-1};
+		float time{};
+		AnimationCursor* cursor{};
+		PoseBlender* blender{};
+		std::uint64_t jobFrame{~0ull};
+		std::size_t job{};
+	};
+	AnimationSlot animationSlot;
+
+private:
+	unsigned dirtyStages_{POSE_ALL};
+	bool dualQuaternionSkinning_{false};
+	int appliedClip_{-1};
+	float appliedTime_{};
 };
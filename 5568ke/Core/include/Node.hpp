@@ -13,13 +13,8 @@ class Node {
 public:
 	Node(int nodeNum);
 
-	// Getters
-	glm::mat4 const& getNodeMatrix() const { return nodeMatrix_; }
-	glm::mat4 const& getLocalTRSMatrix() const { return localTRSMatrix_; }
-
-	// Operations
-	void updateLocalTRSMatrix();
-	void updateNodeMatrix(glm::mat4 const& parentMatrix);
+	// Local transform composed from the TRS components, the matrices themselves live in Model
+	glm::mat4 getLocalTRSMatrix() const;
 
 	// Hierarchy
 	int nodeNum{-1};
@@ -30,18 +25,18 @@ public:
 	glm::vec3 translation{0.0f};
 	glm::quat rotation{1.0f, 0.0f, 0.0f, 0.0f};
 	glm::vec3 scale{1.0f};
-
-private:
-	// Matrices
-	glm::mat4 localTRSMatrix_{1.0f};
-	glm::mat4 nodeMatrix_{1.0f};
 };
 
 namespace NodeUtil {
 
-// Update node tree matrices
-void updateNodeTreeMatricesRecursive(std::shared_ptr<Node> node, glm::mat4 const& parentMatrix);
-void updateNodeListLocalTRSMatrix(std::vector<std::shared_ptr<Node>> const& nodes);
+// Flatten the node tree under model.rootNode into the nodeOrder / nodeOrderParents of model.asset
+void buildNodeHierarchy(Model& model);
+
+// Update the matrices of the flattened hierarchy
+void updateNodeListLocalTRSMatrix(Model& model);
+void updateNodeListGlobalMatrix(Model& model);
 void updateNodeListJointMatrices(Model& model);
+// Convert the joint matrices to dual quaternions, run after updateNodeListJointMatrices
+void updateNodeListJointDualQuaternions(Model& model);
 std::shared_ptr<Node> createRoot(int nodeNum);
 } // namespace NodeUtil
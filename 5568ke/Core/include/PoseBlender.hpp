@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "AnimationTypes.hpp"
+
+class Model;
+
+/**
+ * @brief Layered pose blending of the clips of one model instance.
+ *
+ * The base pose is a crossfade: crossfade() fades whatever plays out and the new clip in over a duration, up to
+ * k_maxFadingClips clips at once. Layers are then applied in order on top of it, an override layer blends its clip
+ * over the pose, an additive layer adds the difference between its clip and the clip's first frame (a nod, a
+ * breathing cycle). Both can be limited to some nodes with a per node weight mask, see buildMask.
+ *
+ * Every clip is sampled into scratch Pose buffers that are sized the first time a model is seen and reused after,
+ * so a frame of blending allocates nothing. Nodes no clip animates keep the TRS the model had at that point.
+ * update() runs on the gameplay thread, apply() on the AnimationSystem thread evaluating the model.
+ */
+class PoseBlender {
+public:
+	static constexpr int k_maxFadingClips = 4;
+	static constexpr int k_maxLayers = 4;
+
+	enum class LayerMode { Override, Additive };
+
+	// Fade from the current pose to this clip, a duration of 0 snaps. A clip still fading out fades back in from its time
+	void crossfade(int clipIndex, float duration, float startTime = 0.0f, float speed = 1.0f, bool loop = true);
+	// Set a layer over the base pose, an empty mask covers every node
+	void setLayer(int layer, int clipIndex, LayerMode mode, float weight, std::vector<float> mask = {}, float speed = 1.0f);
+	void setLayerWeight(int layer, float weight);
+	void clearLayer(int layer);
+	// Forget the clips, the layers and the model the buffers were sized for
+	void reset();
+
+	// Advance the clip times and the fades, returns whether the pose changed and apply() has to run
+	bool update(Model const& model, float dt);
+	// Sample and blend every clip, then write the pose into the nodes of the model
+	void apply(Model& model);
+
+	// Clip fading in (or playing) and its time, -1 when nothing plays
+	int getClip() const;
+	float getTime() const;
+	bool isFading() const;
+
+	// Weight 1 for rootNode and every node below it, 0 elsewhere
+	static std::vector<float> buildMask(Model const& model, int rootNode);
+
+private:
+	struct ClipState {
+		int clipIndex{-1};
+		float time{};
+		float speed{1.0f};
+		bool loop{true};
+		float weight{};
+		float fadeRate{}; // Weight change per second
+		AnimationCursor cursor;
+	};
+	std::array<ClipState, k_maxFadingClips> fading_;
+	int newest_{-1}; // Slot of the last crossfade target
+
+	struct Layer {
+		ClipState clip;
+		LayerMode mode{LayerMode::Override};
+		std::vector<float> mask;
+		Pose reference; // First frame of the clip, additive layers only
+		bool referenceReady{false};
+	};
+	std::array<Layer, k_maxLayers> layers_;
+
+	Model const* model_{nullptr}; // Model the buffers below were sized for
+	Pose restPose_;
+	Pose scratch_;
+	Pose result_;
+	bool dirty_{true};
+
+	void bind_(Model const& model);
+	void sample_(Model const& model, ClipState& state, Pose& out);
+	void advance_(Model const& model, ClipState& state, float dt) const;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 class Material;
 
 /**
@@ -10,4 +12,11 @@ struct Primitive {
 	unsigned int indexCount;	// Number of indices to draw (usually divisible by 3)
 	Material* material;				// Material to bind when drawing this primitive
 	bool doubleSided = false;
+
+	// Simplified versions of the primitive in the same index buffer, each coarser than the previous one (see MeshSimplifier)
+	struct Lod {
+		unsigned int indexOffset;
+		unsigned int indexCount;
+	};
+	std::vector<Lod> lods;
 };
@@ -11,6 +11,8 @@
 #include <glm/mat4x4.hpp>
 
 #include "BoundingBox.hpp"
+#include "DynamicAABBTree.hpp"
+#include "Frustum.hpp"
 #include "GameObject.hpp"
 #include "include_5568ke.hpp"
 
@@ -55,9 +57,15 @@ public:
 	std::vector<std::shared_ptr<GameObject>> gameObjects;
 	std::vector<Light> lights;
 
+	// BVH over the worldBBox of the game objects owning a model, kept up to date by GameObject::updateTransformMatrix
+	DynamicAABBTree spatialIndex;
+
 	// Helper methods for scene management
 	std::shared_ptr<GameObject> addGameObject(std::shared_ptr<Model> model);
+	std::shared_ptr<GameObject> addGameObject(std::shared_ptr<GameObject> gameObject);
 	void removeGameObject(std::string const& name);
+	// Show or hide a game object of the scene, keeps getVisibleIndexedCount up to date
+	void setVisible(GameObject& gameObject, bool visible);
 	std::shared_ptr<GameObject> findGameObject(std::string const& name) const;
 
 	void addLight(glm::vec3 const& position, glm::vec3 const& color = glm::vec3(1.0f), float intensity = 1.0f);
@@ -73,11 +81,61 @@ public:
 	// Scene queries
 	size_t getGameObjectCount() const { return gameObjects.size(); }
 	size_t getVisibleGameObjectCount() const;
+	// Visible objects in spatialIndex, what the renderer draws before frustum culling, without walking gameObjects
+	int getVisibleIndexedCount() const { return visibleIndexedCount_; }
+
+	// Spatial queries through spatialIndex, fn is bool(GameObject&) and returns false to stop the query
+	template <typename Fn>
+	void queryBBox(BoundingBox const& box, Fn&& fn) const;
+	template <typename Fn>
+	void queryRadius(glm::vec3 const& center, float radius, Fn&& fn) const;
+	template <typename Fn>
+	void queryFrustum(Frustum const& frustum, Fn&& fn) const;
 
 	// Cleanup resources
 	void cleanup();
 
 private:
 	Scene() = default;
+	int visibleIndexedCount_{0};
 	~Scene();
-};
\ No newline at end of file
+};
+
+template <typename Fn>
+void Scene::queryBBox(BoundingBox const& box, Fn&& fn) const
+{
+	spatialIndex.query(box, [&](int proxyId) {
+		GameObject& gameObject = *spatialIndex.getUserData(proxyId);
+		if (!BBoxUtil::isIntersectBBox(gameObject.worldBBox, box))
+			return true;
+		return static_cast<bool>(fn(gameObject));
+	});
+}
+
+template <typename Fn>
+void Scene::queryRadius(glm::vec3 const& center, float radius, Fn&& fn) const
+{
+	BoundingBox box{center - glm::vec3(radius), center + glm::vec3(radius)};
+	spatialIndex.query(box, [&](int proxyId) {
+		GameObject& gameObject = *spatialIndex.getUserData(proxyId);
+
+		// Distance from the center to the closest point of the box
+		glm::vec3 closest = glm::clamp(center, gameObject.worldBBox.min, gameObject.worldBBox.max);
+		if (glm::dot(closest - center, closest - center) > radius * radius)
+			return true;
+		return static_cast<bool>(fn(gameObject));
+	});
+}
+
+template <typename Fn>
+void Scene::queryFrustum(Frustum const& frustum, Fn&& fn) const
+{
+	// Subtrees whose box is outside the frustum are skipped as a whole
+	spatialIndex.traverse([&frustum](BoundingBox const& nodeBox) { return FrustumUtil::isBBoxInFrustum(frustum, nodeBox); },
+												[&](int proxyId) {
+													GameObject& gameObject = *spatialIndex.getUserData(proxyId);
+													if (!gameObject.isInFrustum(frustum))
+														return true;
+													return static_cast<bool>(fn(gameObject));
+												});
+}
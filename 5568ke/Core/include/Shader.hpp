@@ -1,25 +1,72 @@
 #pragma once
 
-#include <glm/glm.hpp>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
 
 #include "include_5568ke.hpp"
 
 class Shader {
 public:
+	// Uniform block shared by every shader, filled once per frame by the Renderer
+	static constexpr char const* k_frameDataBlock = "FrameData";
+	static constexpr unsigned int k_frameDataBinding = 0;
+
+	/**
+	 * @brief Typed handle to a uniform location, resolve it once with getUniform and reuse it with send.
+	 * Handles are only valid until the next reload().
+	 */
+	template <typename T>
+	struct Uniform {
+		int location{-1};
+		bool isValid() const { return location >= 0; }
+	};
+
 	void resetShaderPath(std::string const& vertPath, std::string const& fragPath);
 	void reload();
 	void bind() const;
 	void unbind() const;
 
+	// Location from the table reflected at link time, -1 (and a single warning per name) when not active
+	int getUniformLocation(std::string_view name) const;
+	template <typename T>
+	Uniform<T> getUniform(std::string_view name) const
+	{
+		return {getUniformLocation(name)};
+	}
+
+	void send(Uniform<glm::mat4> uniform, glm::mat4 const& mat) const;
+	void send(Uniform<glm::vec3> uniform, glm::vec3 const& vec) const;
+	void send(Uniform<float> uniform, float value) const;
+	void send(Uniform<int> uniform, int value) const;
+	void send(Uniform<bool> uniform, bool value) const;
+
 	void sendMat4(char const* name, glm::mat4 const& mat) const;
 	void sendVec3(char const* name, glm::vec3 const& vec) const;
 	void sendFloat(char const* name, float value) const;
 	void sendInt(char const* name, int value) const;
-	void sendBool(char const* name, bool value) const { glUniform1i(glGetUniformLocation(program_, name), static_cast<int>(value)); }
+	void sendBool(char const* name, bool value) const;
+	// Point a sampler uniform at a texture unit, skipped when it already is (see GLStateCache). Shader must be bound
+	void sendSampler(char const* name, int unit) const;
+	// Upload 'count' matrices to a uniform array in a single call, 'name' is the array name without index
+	void sendMat4Array(char const* name, glm::mat4 const* mats, int count) const;
 
 private:
+	// Transparent hash so lookups by string_view don't build a std::string
+	struct StringHash {
+		using is_transparent = void;
+		std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+	};
+
 	unsigned int program_{};
 	std::string vsPath_;
 	std::string fsPath_;
+
+	// Active uniforms from reflection, plus the names looked up and not found cached as -1 so they warn once
+	mutable std::unordered_map<std::string, int, StringHash, std::equal_to<>> uniformLocations_;
+
+	void reflectUniforms_();
 };
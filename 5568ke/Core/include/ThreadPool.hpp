@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads running CPU only tasks (file I/O, parsing, decoding).
+ *
+ * Tasks must not touch GL, work needing the context is handed to GLUploadQueue instead.
+ * One worker per hardware thread minus the main thread, at least one.
+ *
+ * parallelFor splits per-frame work into chunks that the workers and the calling thread take from a shared counter,
+ * so whoever is free runs the next chunk and a worker busy with a long load never holds up the frame.
+ * The loop state is kept in the pool and reused, so a call allocates nothing. One parallelFor runs at a time.
+ */
+class ThreadPool {
+public:
+	static ThreadPool& getInstance()
+	{
+		static ThreadPool instance;
+		return instance;
+	}
+
+	void submit(std::function<void()> task);
+
+	// Block until every submitted task has finished
+	void waitIdle();
+
+	// Run fn(begin, end) over [0, count) in chunks of at most grain items and return once every chunk ran
+	void parallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> const& fn);
+
+	// Finish the running tasks, drop the queued ones and join the workers, later submits are ignored
+	void shutdown();
+
+	std::size_t getWorkerCount() const { return workers_.size(); }
+
+private:
+	ThreadPool();
+	~ThreadPool() { shutdown(); }
+
+	std::vector<std::thread> workers_;
+	std::deque<std::function<void()>> tasks_;
+	std::mutex mutex_;
+	std::condition_variable taskReady_;
+	std::condition_variable idle_;
+	std::size_t activeTasks_{0};
+	bool stopping_{false};
+
+	// State of the running parallelFor, the helper fields are guarded by mutex_
+	struct Loop {
+		std::function<void(std::size_t, std::size_t)> const* fn{};
+		std::size_t count{};
+		std::size_t grain{};
+		std::size_t chunkCount{};
+		std::atomic<std::size_t> nextChunk{0};
+		std::size_t helpersWanted{}; // Workers that may still join
+		std::size_t helpersActive{}; // Workers running chunks, the loop returns once none is left
+	};
+	Loop loop_;
+	std::mutex loopMutex_; // Serializes parallelFor calls
+	std::condition_variable loopDone_;
+
+	void workerLoop_();
+	void runLoopChunks_();
+};
@@ -4,6 +4,7 @@
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <array>
+#include <cstdint>
 
 /**
  * @brief Represents a single vertex in 3D space, with attributes used in shading and animation.
@@ -17,3 +18,28 @@ struct Vertex {
 	std::array<int, 4> boneIds{}; // Indices of bones influencing the vertex
 	glm::vec4 boneWeights{};			// Weights for each influencing bone
 };
+
+// GPU vertex layouts built from Vertex by Mesh::setup
+enum class VertexLayout { Static, Skinned };
+
+/**
+ * @brief Vertex of a mesh without bone weights, 20 bytes.
+ * The normal is octahedral encoded in two snorm16, the UV is two half floats.
+ */
+struct StaticVertex {
+	glm::vec3 position;
+	std::uint32_t normal;
+	std::uint32_t texcoord;
+};
+
+/**
+ * @brief Vertex of a skinned mesh, 36 bytes.
+ * Same as StaticVertex plus four uint16 joint indices into the model joint palette and their unorm16 weights, which sum to one.
+ */
+struct SkinnedVertex {
+	glm::vec3 position;
+	std::uint32_t normal;
+	std::uint32_t texcoord;
+	std::array<std::uint16_t, 4> boneIds;
+	std::array<std::uint16_t, 4> boneWeights;
+};
@@ -268,6 +268,27 @@ void AnimationChannel::loadChannelData(tinygltf::Model const& model, tinygltf::A
 	// std::cout << "[AnimationChannel INFO] AnimationChannel::loadChannelData - Completed successfully" << std::endl;
 }
 
+// Index of the first keyframe at or after 'time', the callers already handled time outside of (front, back)
+std::size_t AnimationChannel::findNextKeyframe_(float time, std::size_t* keyCursor) const
+{
+	if (keyCursor) {
+		// Playback usually stays in the same key interval or moves to the next one
+		std::size_t last = std::min(*keyCursor + 2, timings_.size() - 1);
+		for (std::size_t i = *keyCursor; i < last; ++i) {
+			if (timings_[i] < time && time <= timings_[i + 1]) {
+				*keyCursor = i;
+				return i + 1;
+			}
+		}
+	}
+
+	// Otherwise (first frame, seek, loop back to start) fall back to a binary search
+	std::size_t nextIdx = static_cast<std::size_t>(std::lower_bound(timings_.begin(), timings_.end(), time) - timings_.begin());
+	if (keyCursor)
+		*keyCursor = nextIdx - 1;
+	return nextIdx;
+}
+
 float AnimationChannel::getMaxTime() const
 {
 	if (timings_.empty()) {
@@ -276,7 +297,7 @@ float AnimationChannel::getMaxTime() const
 	return timings_.back();
 }
 
-glm::vec3 AnimationChannel::getScaling(float time) const
+glm::vec3 AnimationChannel::getScaling(float time, std::size_t* keyCursor) const
 {
 	if (scalings_.empty()) {
 		return glm::vec3(1.0f);
@@ -291,10 +312,7 @@ glm::vec3 AnimationChannel::getScaling(float time) const
 	}
 
 	// Find indices for surrounding keyframes
-	size_t nextIdx = 0;
-	while (nextIdx < timings_.size() && timings_[nextIdx] < time) {
-		nextIdx++;
-	}
+	size_t nextIdx = findNextKeyframe_(time, keyCursor);
 	size_t prevIdx = nextIdx - 1;
 
 	// Handle special case when indices are the same
@@ -342,7 +360,7 @@ glm::vec3 AnimationChannel::getScaling(float time) const
 	return result;
 }
 
-glm::vec3 AnimationChannel::getTranslation(float time) const
+glm::vec3 AnimationChannel::getTranslation(float time, std::size_t* keyCursor) const
 {
 	if (translations_.empty()) {
 		return glm::vec3(0.0f);
@@ -357,10 +375,7 @@ glm::vec3 AnimationChannel::getTranslation(float time) const
 	}
 
 	// Find indices for surrounding keyframes
-	size_t nextIdx = 0;
-	while (nextIdx < timings_.size() && timings_[nextIdx] < time) {
-		nextIdx++;
-	}
+	size_t nextIdx = findNextKeyframe_(time, keyCursor);
 	size_t prevIdx = nextIdx - 1;
 
 	// Handle special case when indices are the same
@@ -408,7 +423,7 @@ glm::vec3 AnimationChannel::getTranslation(float time) const
 	return result;
 }
 
-glm::quat AnimationChannel::getRotation(float time) const
+glm::quat AnimationChannel::getRotation(float time, std::size_t* keyCursor) const
 {
 	if (rotations_.empty()) {
 		return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
@@ -423,10 +438,7 @@ glm::quat AnimationChannel::getRotation(float time) const
 	}
 
 	// Find indices for surrounding keyframes
-	size_t nextIdx = 0;
-	while (nextIdx < timings_.size() && timings_[nextIdx] < time) {
-		nextIdx++;
-	}
+	size_t nextIdx = findNextKeyframe_(time, keyCursor);
 	size_t prevIdx = nextIdx - 1;
 
 	// Handle special case when indices are the same
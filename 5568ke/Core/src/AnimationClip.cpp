@@ -3,6 +3,7 @@
 #include "AnimationClip.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #include <tiny_gltf.h>
@@ -32,19 +33,101 @@ void AnimationClip::addChannel(tinygltf::Model const& model, tinygltf::Animation
 	}
 }
 
-void AnimationClip::setAnimationFrame(std::vector<std::shared_ptr<Node>> const& nodes, float time)
+void AnimationClip::setAnimationFrame(std::vector<std::shared_ptr<Node>> const& nodes, float time, AnimationCursor* cursor)
 {
-	if (nodes.empty() || channels_.empty()) {
+	if (nodes.empty() || (channels_.empty() && !isBaked())) {
 		return;
 	}
 
 	// std::cout << "[AnimationClip] Setting frame at time " << time << " for " << clipName << std::endl;
 
-	// Apply all channels
+	if (isBaked()) {
+		sampleBaked_(nodes, time);
+	}
+	else {
+		applyChannels_(nodes, time, cursor);
+	}
+
+	// The matrices are refreshed by Model::updateLocalMatrices in a single pass over the flattened hierarchy
+}
+
+float AnimationClip::getDuration() const
+{
+	if (channels_.empty()) {
+		return baked_.duration;
+	}
+
+	float maxDuration = 0.0f;
 	for (auto const& channel : channels_) {
+		if (channel) { // Check if channel is valid
+			maxDuration = std::max(maxDuration, channel->getMaxTime());
+		}
+	}
+	return maxDuration;
+}
+
+void AnimationClip::samplePose(Pose& pose, float time, AnimationCursor* cursor) const
+{
+	std::size_t nodeCount = pose.size();
+
+	if (isBaked()) {
+		float frame = std::clamp(time, 0.0f, baked_.duration) * baked_.sampleRate;
+		std::size_t frame0 = std::min(static_cast<std::size_t>(frame), baked_.frameCount - 1);
+		std::size_t frame1 = std::min(frame0 + 1, baked_.frameCount - 1);
+		float t = frame - static_cast<float>(frame0);
+
+		std::size_t slotCount = baked_.nodeIndices.size();
+		std::size_t base0 = frame0 * slotCount;
+		std::size_t base1 = frame1 * slotCount;
+		for (std::size_t slot = 0; slot < slotCount; ++slot) {
+			std::size_t node = static_cast<std::size_t>(baked_.nodeIndices[slot]);
+			if (node >= nodeCount)
+				continue;
+			pose.translations[node] = glm::mix(baked_.translations[base0 + slot], baked_.translations[base1 + slot], t);
+			pose.rotations[node] = glm::normalize(baked_.rotations[base0 + slot] * (1.0f - t) + baked_.rotations[base1 + slot] * t);
+			pose.scales[node] = glm::mix(baked_.scales[base0 + slot], baked_.scales[base1 + slot], t);
+		}
+		return;
+	}
+
+	if (cursor && cursor->keys.size() != channels_.size())
+		cursor->keys.assign(channels_.size(), 0);
+
+	for (std::size_t i = 0; i < channels_.size(); ++i) {
+		auto const& channel = channels_[i];
+		if (!channel || channel->targetNode < 0 || static_cast<std::size_t>(channel->targetNode) >= nodeCount)
+			continue;
+
+		std::size_t* keyCursor = cursor ? &cursor->keys[i] : nullptr;
+		std::size_t node = static_cast<std::size_t>(channel->targetNode);
+		switch (channel->targetPath) {
+		case TargetPath::ROTATION:
+			pose.rotations[node] = channel->getRotation(time, keyCursor);
+			break;
+		case TargetPath::TRANSLATION:
+			pose.translations[node] = channel->getTranslation(time, keyCursor);
+			break;
+		case TargetPath::SCALE:
+			pose.scales[node] = channel->getScaling(time, keyCursor);
+			break;
+		}
+	}
+}
+
+void AnimationClip::applyChannels_(std::vector<std::shared_ptr<Node>> const& nodes, float time, AnimationCursor* cursor) const
+{
+	// A cursor coming from another clip is reset, its indices are validated by the channels anyway
+	if (cursor && cursor->keys.size() != channels_.size())
+		cursor->keys.assign(channels_.size(), 0);
+
+	// Apply all channels
+	for (std::size_t i = 0; i < channels_.size(); ++i) {
+		auto const& channel = channels_[i];
 		if (!channel)
 			continue; // Skip invalid channels
 
+		std::size_t* keyCursor = cursor ? &cursor->keys[i] : nullptr;
+
 		int targetNode = channel->targetNode;
 		if (targetNode < 0 || static_cast<std::size_t>(targetNode) >= nodes.size() || !nodes[targetNode])
 			continue; // Skip invalid target nodes
@@ -58,13 +141,13 @@ void AnimationClip::setAnimationFrame(std::vector<std::shared_ptr<Node>> const&
 		// Apply the animation transforms
 		switch (channel->targetPath) {
 		case TargetPath::ROTATION:
-			node->rotation = channel->getRotation(time);
+			node->rotation = channel->getRotation(time, keyCursor);
 			break;
 		case TargetPath::TRANSLATION:
-			node->translation = channel->getTranslation(time);
+			node->translation = channel->getTranslation(time, keyCursor);
 			break;
 		case TargetPath::SCALE:
-			node->scale = channel->getScaling(time);
+			node->scale = channel->getScaling(time, keyCursor);
 			break;
 		}
 
@@ -79,37 +162,110 @@ void AnimationClip::setAnimationFrame(std::vector<std::shared_ptr<Node>> const&
 			// << glm::length(node->scale) << std::endl;
 		}
 	}
+}
 
-	// Update all nodes' local matrices
-	NodeUtil::updateNodeListLocalTRSMatrix(nodes);
+void AnimationClip::sampleBaked_(std::vector<std::shared_ptr<Node>> const& nodes, float time) const
+{
+	// Two neighbouring frames and one blend factor shared by every node
+	float frame = std::clamp(time, 0.0f, baked_.duration) * baked_.sampleRate;
+	std::size_t frame0 = std::min(static_cast<std::size_t>(frame), baked_.frameCount - 1);
+	std::size_t frame1 = std::min(frame0 + 1, baked_.frameCount - 1);
+	float t = frame - static_cast<float>(frame0);
 
-	// Second pass to update global matrices starting from the root
-	// First find the root node (usually node 0)
-	std::shared_ptr<Node> rootNode;
-	for (auto const& node : nodes) {
-		if (node && node->nodeNum == 0) {
-			rootNode = node;
-			break;
-		}
-	}
+	std::size_t slotCount = baked_.nodeIndices.size();
+	glm::vec3 const* t0 = &baked_.translations[frame0 * slotCount];
+	glm::vec3 const* t1 = &baked_.translations[frame1 * slotCount];
+	glm::quat const* r0 = &baked_.rotations[frame0 * slotCount];
+	glm::quat const* r1 = &baked_.rotations[frame1 * slotCount];
+	glm::vec3 const* s0 = &baked_.scales[frame0 * slotCount];
+	glm::vec3 const* s1 = &baked_.scales[frame1 * slotCount];
 
-	// If root node was found, update matrices starting from it
-	if (rootNode) {
-		NodeUtil::updateNodeTreeMatricesRecursive(rootNode, glm::mat4(1.0f));
+	for (std::size_t slot = 0; slot < slotCount; ++slot) {
+		Node& node = *nodes[baked_.nodeIndices[slot]];
+		node.translation = glm::mix(t0[slot], t1[slot], t);
+		// The rotations were made hemisphere consistent while baking, so a normalized lerp is enough
+		node.rotation = glm::normalize(r0[slot] * (1.0f - t) + r1[slot] * t);
+		node.scale = glm::mix(s0[slot], s1[slot], t);
 	}
 }
 
-float AnimationClip::getDuration() const
+void AnimationClip::bake(std::vector<std::shared_ptr<Node>> const& nodes, float sampleRate)
 {
-	if (channels_.empty()) {
-		return 0.0f;
+	baked_ = BakedTrack{};
+
+	float duration = getDuration();
+	if (channels_.empty() || duration <= 0.0f || sampleRate <= 0.0f)
+		return;
+
+	// One slot per animated node, in node order
+	std::vector<int> slotOfNode(nodes.size(), -1);
+	for (auto const& channel : channels_) {
+		if (channel && channel->targetNode >= 0 && static_cast<std::size_t>(channel->targetNode) < nodes.size() && nodes[channel->targetNode])
+			slotOfNode[channel->targetNode] = 0;
+	}
+	for (std::size_t i = 0; i < nodes.size(); ++i) {
+		if (slotOfNode[i] == 0) {
+			slotOfNode[i] = static_cast<int>(baked_.nodeIndices.size());
+			baked_.nodeIndices.push_back(static_cast<int>(i));
+		}
 	}
 
-	float maxDuration = 0.0f;
+	std::size_t slotCount = baked_.nodeIndices.size();
+	if (slotCount == 0)
+		return;
+
+	std::size_t frameCount = static_cast<std::size_t>(std::ceil(duration * sampleRate)) + 1;
+	baked_.duration = duration;
+	baked_.sampleRate = static_cast<float>(frameCount - 1) / duration;
+	baked_.translations.resize(frameCount * slotCount);
+	baked_.rotations.resize(frameCount * slotCount);
+	baked_.scales.resize(frameCount * slotCount);
+
+	// Every frame starts from the rest pose of the nodes
+	for (std::size_t slot = 0; slot < slotCount; ++slot) {
+		Node const& node = *nodes[baked_.nodeIndices[slot]];
+		for (std::size_t f = 0; f < frameCount; ++f) {
+			baked_.translations[f * slotCount + slot] = node.translation;
+			baked_.rotations[f * slotCount + slot] = node.rotation;
+			baked_.scales[f * slotCount + slot] = node.scale;
+		}
+	}
+
+	// The frames are sampled in increasing time, so each channel walks its keys with a cursor
 	for (auto const& channel : channels_) {
-		if (channel) { // Check if channel is valid
-			maxDuration = std::max(maxDuration, channel->getMaxTime());
+		if (!channel || channel->targetNode < 0 || static_cast<std::size_t>(channel->targetNode) >= nodes.size() || slotOfNode[channel->targetNode] < 0)
+			continue;
+
+		std::size_t slot = static_cast<std::size_t>(slotOfNode[channel->targetNode]);
+		std::size_t keyCursor = 0;
+
+		for (std::size_t f = 0; f < frameCount; ++f) {
+			float time = std::min(static_cast<float>(f) / baked_.sampleRate, duration);
+			std::size_t idx = f * slotCount + slot;
+
+			switch (channel->targetPath) {
+			case TargetPath::ROTATION:
+				baked_.rotations[idx] = channel->getRotation(time, &keyCursor);
+				break;
+			case TargetPath::TRANSLATION:
+				baked_.translations[idx] = channel->getTranslation(time, &keyCursor);
+				break;
+			case TargetPath::SCALE:
+				baked_.scales[idx] = channel->getScaling(time, &keyCursor);
+				break;
+			}
 		}
 	}
-	return maxDuration;
+
+	// Keep consecutive rotations in the same hemisphere so sampling never has to check the sign
+	for (std::size_t f = 1; f < frameCount; ++f) {
+		for (std::size_t slot = 0; slot < slotCount; ++slot) {
+			glm::quat const& prev = baked_.rotations[(f - 1) * slotCount + slot];
+			glm::quat& curr = baked_.rotations[f * slotCount + slot];
+			if (glm::dot(prev, curr) < 0.0f)
+				curr = -curr;
+		}
+	}
+
+	baked_.frameCount = frameCount;
 }
@@ -0,0 +1,101 @@
+#include "AnimationSystem.hpp"
+
+#include <chrono>
+
+#include "GameObject.hpp"
+#include "Model.hpp"
+#include "PoseBlender.hpp"
+#include "Scene.hpp"
+#include "ThreadPool.hpp"
+
+void AnimationSystem::play(Model& model, int clipIndex, float time, AnimationCursor* cursor)
+{
+	Model::AnimationSlot& slot = model.animationSlot;
+	slot.requestFrame = frame_;
+	slot.clipIndex = clipIndex;
+	slot.time = time;
+	slot.cursor = cursor;
+	slot.blender = nullptr;
+}
+
+void AnimationSystem::play(Model& model, PoseBlender& blender)
+{
+	Model::AnimationSlot& slot = model.animationSlot;
+	slot.requestFrame = frame_;
+	slot.clipIndex = -1;
+	slot.cursor = nullptr;
+	slot.blender = &blender;
+}
+
+void AnimationSystem::update(Scene& scene)
+{
+	stats_ = Stats();
+
+	// Game objects sharing a model would race on it, each model is evaluated once
+	jobs_.clear();
+	for (auto const& goPtr : scene.gameObjects) {
+		if (!goPtr || !goPtr->hasModel())
+			continue;
+
+		Model* model = goPtr->getModel().get();
+		Model::AnimationSlot& slot = model->animationSlot;
+		if (slot.jobFrame == frame_)
+			continue;
+
+		slot.jobFrame = frame_;
+		slot.job = jobs_.size();
+		jobs_.push_back(Job{model, slot.requestFrame == frame_, 0});
+	}
+
+	auto evaluate = [this](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			Job& job = jobs_[i];
+			Model::AnimationSlot const& slot = job.model->animationSlot;
+			if (job.requested && slot.blender)
+				slot.blender->apply(*job.model);
+			else if (job.requested)
+				job.model->applyAnimationFrame(slot.clipIndex, slot.time, slot.cursor);
+			job.stages = job.model->updatePose();
+		}
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	ThreadPool& pool = ThreadPool::getInstance();
+	if (parallel && jobs_.size() > k_modelsPerChunk) {
+		pool.parallelFor(jobs_.size(), k_modelsPerChunk, evaluate);
+		stats_.threads = static_cast<int>(pool.getWorkerCount()) + 1;
+	}
+	else {
+		evaluate(0, jobs_.size());
+		stats_.threads = 1;
+	}
+	stats_.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	for (Job const& job : jobs_) {
+		stats_.models++;
+		bool blended = job.requested && job.model->animationSlot.blender;
+		stats_.sampledClips += job.requested && !blended ? 1 : 0;
+		stats_.blendedModels += blended ? 1 : 0;
+		if (job.stages == 0) {
+			stats_.cleanModels++;
+			continue;
+		}
+
+		stats_.localPasses += (job.stages & Model::POSE_LOCAL) ? 1 : 0;
+		stats_.globalPasses += (job.stages & Model::POSE_GLOBAL) ? 1 : 0;
+		stats_.jointPasses += (job.stages & Model::POSE_JOINTS) ? 1 : 0;
+		stats_.boundsPasses += (job.stages & Model::POSE_BOUNDS) ? 1 : 0;
+	}
+
+	// The model space bounds moved, so does the world space box. Back on the calling thread, the spatial index is shared
+	for (auto const& goPtr : scene.gameObjects) {
+		if (!goPtr || !goPtr->hasModel())
+			continue;
+		Model::AnimationSlot const& slot = goPtr->getModel()->animationSlot;
+		if (slot.jobFrame == frame_ && (jobs_[slot.job].stages & Model::POSE_BOUNDS))
+			goPtr->updateTransformMatrix();
+	}
+
+	// Requests queued from here on are for the next update
+	frame_++;
+}
@@ -3,16 +3,21 @@
 #include "Application.hpp"
 
 #include <cmath>
+#include <functional>
 #include <iostream>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "AnimationClip.hpp"
+#include "AnimationSystem.hpp"
 #include "Collider.hpp"
 #include "CollisionSystem.hpp"
 #include "DialogSystem.hpp"
+#include "GLUploadQueue.hpp"
 #include "Model.hpp"
+#include "TextureCache.hpp"
+#include "TextureCompressor.hpp"
 
 Application::Application() {}
 Application::~Application() { cleanup_(); }
@@ -116,126 +121,93 @@ void Application::scrollCallback_(GLFWwindow* window, double xoffset, double yof
 
 void Application::initGL_()
 {
+	GLUploadQueue::getInstance().setGLThread();
+
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         std::cerr << "Failed to initialize GLAD" << std::endl;
         // Consider exiting or throwing an exception
     }
+
+	// Lets the model loaders compress textures on their worker threads
+	TextureCompressor::detectSupport();
 }
 
 void Application::setupDefaultScene_()
 {
-	sceneRef.addLight(glm::vec3(1.0f, 7.0f, -4.0f), glm::vec3(1.0f), 2.0f);
+	sceneRef.addLight(glm::vec3(1.0f, 7.0f, -4.0f), glm::vec3(1.0f), 1.0f);
 
 	try {
 		rendererRef.init();
-		std::shared_ptr<GameObject> teacherGO = nullptr;
-
-		{
-			std::string const inaPath = "assets/models/smo_ina/scene.gltf";
-			std::string const playerName = "Player";
-			std::shared_ptr<Model> playerModel = registryRef.loadModel(inaPath, playerName);
-			if (playerModel) {
-				auto goPtr = registryRef.addModelToScene(sceneRef, playerModel);
-				if (goPtr) {
-					goPtr->position = {5.2f, 0.12f, -1.0f};
-					goPtr->rotationDeg.y = 50;
-					goPtr->updateTransformMatrix(); // IMPORTANT: Update transform after setting properties
-					auto modelCol = std::make_shared<AABBCollider>(goPtr);
-					collisionSysRef.add(modelCol);
-					animStateRef.characterMoveMode = true;
-				}
-				animStateRef.gameObjectName = playerName;
-				sceneRef.setupCameraToViewGameObject(playerName);
-			}
-		}
-
-		{
-			std::string const amePath = "assets/models/smo_ame/scene.gltf";
-			std::string const ameName = "ame";
-			std::shared_ptr<Model> ameModel = registryRef.loadModel(amePath, ameName);
-			if (ameModel) {
-				auto goPtr = registryRef.addModelToScene(sceneRef, ameModel);
-				if (goPtr) {
-					goPtr->position = {8.5f, 0.38f, 0.18f};
-					goPtr->rotationDeg.y = -90;
-					goPtr->updateTransformMatrix(); // IMPORTANT
-					auto modelCol = std::make_shared<AABBCollider>(goPtr);
-					collisionSysRef.add(modelCol);
-					teacherGO = goPtr;
-				}
-			}
-		}
-
-		{
-			std::string const calliPath = "assets/models/smo_calli/scene.gltf";
-			std::string const calliName = "calli";
-			std::shared_ptr<Model> calliModel = registryRef.loadModel(calliPath, calliName);
-			if (calliModel) {
-				auto goPtr = registryRef.addModelToScene(sceneRef, calliModel);
-				if (goPtr) {
-					goPtr->position = {6.369f, 0.12f, 2.834f};
-					goPtr->scale = glm::vec3(0.35f);
-					goPtr->rotationDeg.y = -161;
-					goPtr->updateTransformMatrix(); // IMPORTANT
-					auto modelCol = std::make_shared<AABBCollider>(goPtr);
-					collisionSysRef.add(modelCol);
-					initA(goPtr);
-				}
-			}
-		}
 
-		{
-			std::string const kiaraPath = "assets/models/smo_kiara/scene.gltf";
-			std::string const kiaraName = "kiara";
-			std::shared_ptr<Model> kiaraModel = registryRef.loadModel(kiaraPath, kiaraName);
-			if (kiaraModel) {
-				auto goPtr = registryRef.addModelToScene(sceneRef, kiaraModel);
-				if (goPtr) {
-					goPtr->position = {7.38f, 0.12f, -1.538f};
-					goPtr->rotationDeg.y = -42;
-					goPtr->updateTransformMatrix(); // IMPORTANT
-					auto modelCol = std::make_shared<AABBCollider>(goPtr);
-					collisionSysRef.add(modelCol);
-					initB(goPtr);
+		// The models load on the worker threads while the main menu is shown, each one is placed when it arrives
+		auto loadSceneModel = [this](std::string const& path, std::string const& name, std::function<void(std::shared_ptr<GameObject>)> place) {
+			pendingSceneModels_++;
+			registryRef.loadModelAsync(path, name, [this, place](std::shared_ptr<Model> model) {
+				if (model) {
+					auto goPtr = registryRef.addModelToScene(sceneRef, model);
+					if (goPtr)
+						place(goPtr);
 				}
-			}
-		}
-
-		{
-			std::string const guraPath = "assets/models/smo_gura/scene.gltf";
-			std::string const guraName = "gura";
-			std::shared_ptr<Model> guraModel = registryRef.loadModel(guraPath, guraName);
-			if (guraModel) {
-				auto goPtr = registryRef.addModelToScene(sceneRef, guraModel);
-				if (goPtr) {
-					goPtr->position = {7.744f, 0.12f, 2.284f};
-					goPtr->scale = glm::vec3(0.35f);
-					goPtr->rotationDeg.y = -141.503f;
-					goPtr->updateTransformMatrix(); // IMPORTANT
-					auto modelCol = std::make_shared<AABBCollider>(goPtr);
-					collisionSysRef.add(modelCol);
-					initC(goPtr);
-				}
-			}
-		}
-
-		{
-			std::string const classRoomPath = "assets/models/japanese_classroom/scene.gltf";
-			std::string const classRoomName = "classroom";
-			std::shared_ptr<Model> classRoomModel = registryRef.loadModel(classRoomPath, classRoomName);
-			if (classRoomModel) {
-				auto goPtr = registryRef.addModelToScene(sceneRef, classRoomModel);
-				if (goPtr) {
-					goPtr->position = {8.4f, 0.0f, 7.0f};
-					goPtr->scale = glm::vec3(2.6f);
-					goPtr->updateTransformMatrix(); // IMPORTANT
-				}
-			}
-		}
-		if (teacherGO) {
-			initBegin(teacherGO);
-			std::cout << "[Application] Dialog system initialized with teacher and character routes" << std::endl;
-		}
+				if (--pendingSceneModels_ == 0)
+					onDefaultSceneLoaded_();
+			});
+		};
+
+		std::string const playerName = "Player";
+		loadSceneModel("assets/models/smo_ina/scene.gltf", playerName, [this, playerName](std::shared_ptr<GameObject> goPtr) {
+			goPtr->position = {5.2f, 0.12f, -1.0f};
+			goPtr->rotationDeg.y = 50;
+			goPtr->updateTransformMatrix(); // IMPORTANT: Update transform after setting properties
+			auto modelCol = std::make_shared<AABBCollider>(goPtr);
+			collisionSysRef.add(modelCol);
+			animStateRef.characterMoveMode = true;
+			animStateRef.gameObjectName = playerName;
+			sceneRef.setupCameraToViewGameObject(playerName);
+		});
+
+		loadSceneModel("assets/models/smo_ame/scene.gltf", "ame", [this](std::shared_ptr<GameObject> goPtr) {
+			goPtr->position = {8.5f, 0.38f, 0.18f};
+			goPtr->rotationDeg.y = -90;
+			goPtr->updateTransformMatrix(); // IMPORTANT
+			auto modelCol = std::make_shared<AABBCollider>(goPtr);
+			collisionSysRef.add(modelCol);
+			teacherGO_ = goPtr;
+		});
+
+		loadSceneModel("assets/models/smo_calli/scene.gltf", "calli", [this](std::shared_ptr<GameObject> goPtr) {
+			goPtr->position = {6.369f, 0.12f, 2.834f};
+			goPtr->scale = glm::vec3(0.35f);
+			goPtr->rotationDeg.y = -161;
+			goPtr->updateTransformMatrix(); // IMPORTANT
+			auto modelCol = std::make_shared<AABBCollider>(goPtr);
+			collisionSysRef.add(modelCol);
+			routeGOs_[0] = goPtr;
+		});
+
+		loadSceneModel("assets/models/smo_kiara/scene.gltf", "kiara", [this](std::shared_ptr<GameObject> goPtr) {
+			goPtr->position = {7.38f, 0.12f, -1.538f};
+			goPtr->rotationDeg.y = -42;
+			goPtr->updateTransformMatrix(); // IMPORTANT
+			auto modelCol = std::make_shared<AABBCollider>(goPtr);
+			collisionSysRef.add(modelCol);
+			routeGOs_[1] = goPtr;
+		});
+
+		loadSceneModel("assets/models/smo_gura/scene.gltf", "gura", [this](std::shared_ptr<GameObject> goPtr) {
+			goPtr->position = {7.744f, 0.12f, 2.284f};
+			goPtr->scale = glm::vec3(0.35f);
+			goPtr->rotationDeg.y = -141.503f;
+			goPtr->updateTransformMatrix(); // IMPORTANT
+			auto modelCol = std::make_shared<AABBCollider>(goPtr);
+			collisionSysRef.add(modelCol);
+			routeGOs_[2] = goPtr;
+		});
+
+		loadSceneModel("assets/models/japanese_classroom/scene.gltf", "classroom", [](std::shared_ptr<GameObject> goPtr) {
+			goPtr->position = {8.4f, 0.0f, 7.0f};
+			goPtr->scale = glm::vec3(2.6f);
+			goPtr->updateTransformMatrix(); // IMPORTANT
+		});
 
 		// Add invisible walls around the classroom
 		addInvisibleWalls_();
@@ -245,6 +217,22 @@ void Application::setupDefaultScene_()
 	}
 }
 
+void Application::onDefaultSceneLoaded_()
+{
+	// The NPCs are registered in the same order as before the loading went asynchronous
+	if (routeGOs_[0])
+		initA(routeGOs_[0]);
+	if (routeGOs_[1])
+		initB(routeGOs_[1]);
+	if (routeGOs_[2])
+		initC(routeGOs_[2]);
+
+	if (teacherGO_) {
+		initBegin(teacherGO_);
+		std::cout << "[Application] Dialog system initialized with teacher and character routes" << std::endl;
+	}
+}
+
 void Application::processInput_(float dt)
 {
 	int cursorMode = glfwGetInputMode(window_, GLFW_CURSOR);
@@ -277,13 +265,13 @@ void Application::processInput_(float dt)
 				}
 
 				// Animation state handling
-				if (gameObject.hasModel() && !gameObject.getModel()->animations.empty()) {
+				if (gameObject.hasModel() && !gameObject.getModel()->asset->animations.empty()) {
                     int idleAnimIndex = dialogSysRef.findIdleAnimationIndex(goSharedPtr); // Or a predefined idle index
                     int walkAnimIndex = 1; // Assuming 1 is a walk/move animation, adjust as needed
-                    if (static_cast<size_t>(walkAnimIndex) >= gameObject.getModel()->animations.size() || !gameObject.getModel()->animations[walkAnimIndex]) {
+                    if (static_cast<size_t>(walkAnimIndex) >= gameObject.getModel()->asset->animations.size() || !gameObject.getModel()->asset->animations[walkAnimIndex]) {
                         walkAnimIndex = 0; // Fallback to a safe animation
                     }
-                     if (idleAnimIndex == -1 || static_cast<size_t>(idleAnimIndex) >= gameObject.getModel()->animations.size() || !gameObject.getModel()->animations[idleAnimIndex]) {
+                     if (idleAnimIndex == -1 || static_cast<size_t>(idleAnimIndex) >= gameObject.getModel()->asset->animations.size() || !gameObject.getModel()->asset->animations[idleAnimIndex]) {
                         idleAnimIndex = 0; // Fallback
                     }
 
@@ -291,15 +279,12 @@ void Application::processInput_(float dt)
 					if (isMoving && !animStateRef.wasMoving) { // Started moving
 						animStateRef.clipIndex = walkAnimIndex;
 						animStateRef.play(animStateRef.clipIndex, 0.0f);
+						animStateRef.blender.crossfade(walkAnimIndex, animStateRef.crossfadeDuration);
 					} else if (!isMoving && animStateRef.wasMoving) { // Stopped moving
 						animStateRef.stop();
                         animStateRef.clipIndex = idleAnimIndex; // Switch to idle animation clip
-                        // Reset idle animation to its start if you want it to always restart
-                        // This might conflict with DialogSystem's idle animation handling if not careful
-                        if(gameObject.getModel()->animations[animStateRef.clipIndex]) {
-						    gameObject.getModel()->animations[animStateRef.clipIndex]->setAnimationFrame(gameObject.getModel()->nodes, 0.0f);
-						    gameObject.getModel()->updateLocalMatrices();
-                        }
+                        // Fade into the first frame of the idle clip instead of snapping to it, held like before
+                        animStateRef.blender.crossfade(idleAnimIndex, animStateRef.crossfadeDuration, 0.0f, 0.0f);
 					}
 				}
 				animStateRef.wasMoving = isMoving;
@@ -309,28 +294,16 @@ void Application::processInput_(float dt)
 		}
 	}
 
-	// Update player animation if moving and animation is playing
-	if (animStateRef.isAnimating && animStateRef.wasMoving && charMode && !animStateRef.gameObjectName.empty()) {
+	// Player pose, walk and idle crossfade in the blender and are blended with the NPCs by AnimationSystem::update
+	if (charMode && !animStateRef.gameObjectName.empty()) {
 		auto goSharedPtr = sceneRef.findGameObject(animStateRef.gameObjectName);
-		if (goSharedPtr && goSharedPtr->hasModel() && !goSharedPtr->getModel()->animations.empty()) {
-			GameObject& gameObject = *goSharedPtr;
-			int currentClipIdx = animStateRef.clipIndex;
-
-			if (currentClipIdx >= 0 && static_cast<size_t>(currentClipIdx) < gameObject.getModel()->animations.size() && gameObject.getModel()->animations[currentClipIdx]) {
-				auto& animClip = gameObject.getModel()->animations[currentClipIdx];
-				animStateRef.currentTime += dt * animStateRef.getAnimateSpeed();
-				float duration = animClip->getDuration();
-				if (duration > 0.0f) {
-					animStateRef.currentTime = std::fmod(animStateRef.currentTime, duration);
-				} else {
-					animStateRef.currentTime = 0.0f;
-				}
-				animClip->setAnimationFrame(gameObject.getModel()->nodes, animStateRef.currentTime);
-				gameObject.getModel()->updateLocalMatrices(); // Ensure model matrices are updated after animation
-			} else {
-                 // std::cerr << "Player animation: Invalid clip index " << currentClipIdx << std::endl;
-                 animStateRef.stop();
-            }
+		if (goSharedPtr && goSharedPtr->hasModel() && !goSharedPtr->getModel()->asset->animations.empty()) {
+			Model& model = *goSharedPtr->getModel();
+			bool paused = animStateRef.wasMoving && !animStateRef.isAnimating; // Walk paused from the animation panel
+			if (!paused && animStateRef.blender.update(model, dt * animStateRef.getAnimateSpeed()))
+				AnimationSystem::getInstance().play(model, animStateRef.blender);
+			if (animStateRef.wasMoving)
+				animStateRef.currentTime = animStateRef.blender.getTime();
 		}
 	}
 }
@@ -346,6 +319,8 @@ void Application::tick_(float dt)
 	// Other game logic updates can go here
 	// For example, physics updates for all dynamic objects, AI updates not handled by DialogSystem etc.
 
+	AnimationSystem::getInstance().update(sceneRef); // Samples the queued clips and rebuilds the matrices and bounds of every model in parallel
+
 	collisionSysRef.update(); // Handles collision detection and resolution
 
 	// Update camera follow if in character mode
@@ -395,10 +370,12 @@ void Application::loop_()
 		if (dt > 0.1f) dt = 0.1f;     // Clamp dt to prevent instability from large frame drops
 
 		glfwPollEvents(); // Poll events first
+		registryRef.update(); // GL uploads and callbacks of the models loading in the background
 		
 		// Handle main menu
 		if (mainMenuRef.isVisible()) {
 			mainMenuRef.processInput(window_);
+			mainMenuRef.setPendingLoads(registryRef.getPendingLoads());
 			
 			// Only render main menu, skip game logic
 			int w, h;
@@ -434,9 +411,16 @@ void Application::loop_()
 
 void Application::cleanup_()
 {
+	registryRef.cleanup(); // Stop the loader threads before the models and the GL context go away
 	ImGuiManagerRef.cleanup();
+
+	// Release every model while the context is current, the singletons would only drop theirs after glfwTerminate
+	teacherGO_.reset();
+	dialogSysRef.cleanup();
+	collisionSysRef.cleanup();
 	sceneRef.cleanup();
 	rendererRef.cleanup();
+	TextureCache::getInstance().clear();
 	if (window_) {
 		glfwDestroyWindow(window_);
 		window_ = nullptr;
@@ -463,7 +447,7 @@ void Application::addInvisibleWalls_()
 		wallGO->restitution = 0.1f; // Low bounce
 		wallGO->updateTransformMatrix();
 				// Add to scene
-		sceneRef.gameObjects.push_back(wallGO);
+		sceneRef.addGameObject(wallGO);
 		
 		// Create and add collider
 		auto wallCollider = std::make_shared<AABBCollider>(wallGO);
@@ -0,0 +1,82 @@
+#include "GLStateCache.hpp"
+
+#include <algorithm>
+
+#include "include_5568ke.hpp"
+
+bool GLStateCache::useProgram(unsigned int program)
+{
+	if (!track_(program_ != program))
+		return false;
+
+	program_ = program;
+	glUseProgram(program);
+	return true;
+}
+
+bool GLStateCache::activeTexture(unsigned int unit)
+{
+	if (!track_(activeUnit_ != unit))
+		return false;
+
+	activeUnit_ = unit;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	return true;
+}
+
+bool GLStateCache::bindTexture2D(unsigned int unit, unsigned int texture)
+{
+	// Units past the shadow copy are always bound
+	if (unit >= k_maxTextureUnits) {
+		activeTexture(unit);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		return true;
+	}
+
+	if (!track_(textures2D_[unit] != texture))
+		return false;
+
+	activeTexture(unit);
+	textures2D_[unit] = texture;
+	glBindTexture(GL_TEXTURE_2D, texture);
+	return true;
+}
+
+bool GLStateCache::setSampler(unsigned int program, int location, int unit)
+{
+	if (location < 0)
+		return false;
+
+	std::uint64_t key = (static_cast<std::uint64_t>(program) << 32) | static_cast<std::uint32_t>(location);
+	auto [it, inserted] = samplerUnits_.try_emplace(key, unit);
+	if (!track_(inserted || it->second != unit))
+		return false;
+
+	it->second = unit;
+	glUniform1i(location, unit);
+	return true;
+}
+
+void GLStateCache::invalidate()
+{
+	program_ = k_unknown;
+	activeUnit_ = k_unknown;
+	textures2D_.fill(k_unknown);
+}
+
+void GLStateCache::forgetProgram(unsigned int program)
+{
+	if (program_ == program)
+		program_ = k_unknown;
+
+	std::erase_if(samplerUnits_, [program](auto const& entry) { return (entry.first >> 32) == program; });
+}
+
+bool GLStateCache::track_(bool changed)
+{
+	if (changed)
+		stats_.issued++;
+	else
+		stats_.skipped++;
+	return changed;
+}
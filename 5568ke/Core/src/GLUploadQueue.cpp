@@ -0,0 +1,66 @@
+#include "GLUploadQueue.hpp"
+
+#include <chrono>
+
+void GLUploadQueue::push(std::function<void()> job)
+{
+	std::lock_guard lock(mutex_);
+	jobs_.push_back(std::move(job));
+}
+
+std::size_t GLUploadQueue::drain(double budgetMs)
+{
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start = Clock::now();
+
+	std::size_t count = 0;
+	std::function<void()> job;
+	while (popJob_(job)) {
+		job();
+		job = nullptr; // Release the captured data before measuring
+		count++;
+
+		if (std::chrono::duration<double, std::milli>(Clock::now() - start).count() >= budgetMs)
+			break;
+	}
+	return count;
+}
+
+std::size_t GLUploadQueue::drainAll()
+{
+	std::size_t count = 0;
+	std::function<void()> job;
+	while (popJob_(job)) {
+		job();
+		job = nullptr;
+		count++;
+	}
+	return count;
+}
+
+void GLUploadQueue::clear()
+{
+	// Destroy the jobs outside the lock, their captures may push (e.g. a texture deleter)
+	std::deque<std::function<void()>> jobs;
+	{
+		std::lock_guard lock(mutex_);
+		jobs.swap(jobs_);
+	}
+}
+
+std::size_t GLUploadQueue::getPendingCount()
+{
+	std::lock_guard lock(mutex_);
+	return jobs_.size();
+}
+
+bool GLUploadQueue::popJob_(std::function<void()>& job)
+{
+	std::lock_guard lock(mutex_);
+	if (jobs_.empty())
+		return false;
+
+	job = std::move(jobs_.front());
+	jobs_.pop_front();
+	return true;
+}
@@ -10,6 +10,7 @@
 #include <glm/gtx/string_cast.hpp>
 
 #include "BoundingBox.hpp"
+#include "DynamicAABBTree.hpp"
 #include "Model.hpp"
 
 // Constructors
@@ -53,11 +54,23 @@ void GameObject::updateTransformMatrix()
 			worldMin = glm::min(worldMin, worldCorner);
 			worldMax = glm::max(worldMax, worldCorner);
 		}
+		// Refit the scene BVH, small moves stay inside the fat leaf and leave the tree untouched
+		if (spatialIndex_) {
+			glm::vec3 displacement = (worldMin + worldMax) * 0.5f - BBoxUtil::getBBoxCenter(worldBBox);
+			spatialIndex_->moveProxy(spatialProxy_, {worldMin, worldMax}, displacement);
+		}
+
 		worldBBox.min = worldMin;
 		worldBBox.max = worldMax;
 	}
 }
 
+void GameObject::attachSpatialIndex(DynamicAABBTree* tree, int proxyId)
+{
+	spatialIndex_ = tree;
+	spatialProxy_ = proxyId;
+}
+
 void GameObject::setTransform(glm::mat4 const& newTransform)
 {
 	transform_ = newTransform;
@@ -119,35 +132,14 @@ glm::vec3 GameObject::directionTo(GameObject const& other) const
 }
 
 // Bounds and collision
-bool GameObject::isInFrustum(glm::mat4 const& viewProjectionMatrix) const
+bool GameObject::isInFrustum(Frustum const& frustum) const
 {
 	if (!model_) {
 		return false;
 	}
 
-	// Get the model's bounding box
-	BoundingBox bbox = model_->localSpaceBBox;
-
-	// Transform the 8 corners of the bounding box to world space
-	glm::vec3 corners[8] = {{bbox.min.x, bbox.min.y, bbox.min.z}, {bbox.max.x, bbox.min.y, bbox.min.z}, {bbox.min.x, bbox.max.y, bbox.min.z},
-													{bbox.max.x, bbox.max.y, bbox.min.z}, {bbox.min.x, bbox.min.y, bbox.max.z}, {bbox.max.x, bbox.min.y, bbox.max.z},
-													{bbox.min.x, bbox.max.y, bbox.max.z}, {bbox.max.x, bbox.max.y, bbox.max.z}};
-
-	// Check if any corner is inside the frustum
-	for (auto const& corner : corners) {
-		glm::vec4 worldPos = transform_ * glm::vec4(corner, 1.0f);
-		glm::vec4 clipPos = viewProjectionMatrix * worldPos;
-
-		// Check if the point is within the clip space
-		if (clipPos.w > 0.0f) {
-			glm::vec3 ndc = glm::vec3(clipPos) / clipPos.w;
-			if (ndc.x >= -1.0f && ndc.x <= 1.0f && ndc.y >= -1.0f && ndc.y <= 1.0f && ndc.z >= -1.0f && ndc.z <= 1.0f) {
-				return true;
-			}
-		}
-	}
-
-	return false;
+	// Testing the box against the planes keeps objects surrounding the camera (e.g. the classroom) visible
+	return FrustumUtil::isBBoxInFrustum(frustum, worldBBox);
 }
 
 // Debug and utility
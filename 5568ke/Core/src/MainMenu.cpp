@@ -152,6 +152,10 @@ void MainMenu::render()
             
             ImGui::TextWrapped("快速提示: 使用 WASD 移動，E 鍵互動，Tab 切換滑鼠模式");
             ImGui::TextWrapped("按 Enter 開始遊戲，ESC 退出");
+
+            // Models still loading in the background
+            if (pendingLoads_ > 0)
+                ImGui::Text("載入模型中... (剩餘 %d)", pendingLoads_);
             
             ImGui::SetWindowFontScale(1.0f);
             ImGui::PopStyleColor();
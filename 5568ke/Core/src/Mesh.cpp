@@ -6,8 +6,66 @@
 #include "Vertex.hpp"
 #include "include_5568ke.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+#include <glm/packing.hpp>
+
+namespace {
+// Octahedral encoding: project on the octahedron, fold the lower half over the upper one
+std::uint32_t encodeNormal(glm::vec3 const& n)
+{
+	float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	if (sum == 0.0f)
+		return glm::packSnorm2x16(glm::vec2(0.0f, 0.0f));
+
+	glm::vec2 p(n.x / sum, n.y / sum);
+	if (n.z < 0.0f)
+		p = glm::vec2((1.0f - std::abs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f));
+	return glm::packSnorm2x16(p);
+}
+
+void packStaticVertex(Vertex const& v, StaticVertex& out)
+{
+	out.position = v.position;
+	out.normal = encodeNormal(v.normal);
+	out.texcoord = glm::packHalf2x16(v.texcoord);
+}
+
+// Weights are renormalized and quantized to unorm16, the rounding error goes to the largest one so they sum to exactly one
+void packSkinnedVertex(Vertex const& v, SkinnedVertex& out)
+{
+	out.position = v.position;
+	out.normal = encodeNormal(v.normal);
+	out.texcoord = glm::packHalf2x16(v.texcoord);
+
+	float weights[4] = {v.boneWeights.x, v.boneWeights.y, v.boneWeights.z, v.boneWeights.w};
+	float sum = weights[0] + weights[1] + weights[2] + weights[3];
+
+	int total = 0;
+	int largest = 0;
+	for (int i = 0; i < 4; ++i) {
+		out.boneIds[i] = static_cast<std::uint16_t>(std::clamp(v.boneIds[i], 0, 65535));
+		out.boneWeights[i] = sum > 0.0f ? static_cast<std::uint16_t>(std::lround(std::max(weights[i], 0.0f) / sum * 65535.0f)) : 0;
+		total += out.boneWeights[i];
+		if (weights[i] > weights[largest])
+			largest = i;
+	}
+	if (total > 0)
+		out.boneWeights[largest] = static_cast<std::uint16_t>(std::clamp(out.boneWeights[largest] + 65535 - total, 0, 65535));
+}
+} // namespace
+
 void Mesh::setup()
 {
+	// Skinning attributes are only stored for meshes that have bone weights
+	bool skinned = std::any_of(vertices.begin(), vertices.end(), [](Vertex const& v) {
+		return v.boneWeights.x + v.boneWeights.y + v.boneWeights.z + v.boneWeights.w > 0.0f;
+	});
+	layout_ = skinned ? VertexLayout::Skinned : VertexLayout::Static;
+
 	glGenVertexArrays(1, &vao_);
 	glGenBuffers(1, &vbo_);
 	glGenBuffers(1, &ebo_);
@@ -15,30 +73,57 @@ void Mesh::setup()
 	glBindVertexArray(vao_);
 
 	glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+	GLsizei stride;
+	if (skinned) {
+		std::vector<SkinnedVertex> packed(vertices.size());
+		for (std::size_t i = 0; i < vertices.size(); ++i)
+			packSkinnedVertex(vertices[i], packed[i]);
+		glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(SkinnedVertex), packed.data(), GL_STATIC_DRAW);
+		stride = sizeof(SkinnedVertex);
+	}
+	else {
+		std::vector<StaticVertex> packed(vertices.size());
+		for (std::size_t i = 0; i < vertices.size(); ++i)
+			packStaticVertex(vertices[i], packed[i]);
+		glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(StaticVertex), packed.data(), GL_STATIC_DRAW);
+		stride = sizeof(StaticVertex);
+	}
 
+	// Half the index bandwidth whenever the vertex count allows it
+	shortIndices_ = vertices.size() <= 65536;
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+	if (shortIndices_) {
+		std::vector<std::uint16_t> shortIndices(indices.begin(), indices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(std::uint16_t), shortIndices.data(), GL_STATIC_DRAW);
+	}
+	else {
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+	}
 
-	// Position attribute
+	// Position attribute, the same offsets in both layouts
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(StaticVertex, position));
 
-	// Normal attribute
+	// Normal attribute, octahedral encoded, decoded in the vertex shader
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+	glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(StaticVertex, normal));
 
 	// Texcoord attribute
 	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texcoord));
+	glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(StaticVertex, texcoord));
+
+	if (skinned) {
+		// Bone ID attribute
+		glEnableVertexAttribArray(3);
+		glVertexAttribIPointer(3, 4, GL_UNSIGNED_SHORT, stride, (void*)offsetof(SkinnedVertex, boneIds));
 
-	// Bone ID attribute
-	glEnableVertexAttribArray(3);
-	glVertexAttribIPointer(3, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, boneIds));
+		// Bone weight attribute
+		glEnableVertexAttribArray(4);
+		glVertexAttribPointer(4, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(SkinnedVertex, boneWeights));
+	}
 
-	// Bone weight attribute
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, boneWeights));
+	// Attribute 4 stays disabled on a static mesh, whoever draws it with the skinned shader sets the generic value
+	// (context state, not part of the VAO) to zero weights right before the draw
 
 	glBindVertexArray(0);
 }
@@ -48,6 +133,10 @@ void Mesh::draw(Shader const& shader) const
 	glBindVertexArray(vao_);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
 
+	// Zero bone weights keep a mesh without weights in the bind pose when the shader is the skinned one
+	if (layout_ == VertexLayout::Static)
+		glVertexAttrib4f(4, 0.0f, 0.0f, 0.0f, 0.0f);
+
 	for (auto const& prim : primitives) {
 		if (prim.material)
 			prim.material->bind(shader);
@@ -55,10 +144,12 @@ void Mesh::draw(Shader const& shader) const
 		if (prim.doubleSided)
 			glDisable(GL_CULL_FACE);
 
-		glDrawElements(GL_TRIANGLES, prim.indexCount, GL_UNSIGNED_INT, (void*)(prim.indexOffset * sizeof(unsigned)));
+		glDrawElements(GL_TRIANGLES, prim.indexCount, getIndexType(), (void*)(prim.indexOffset * getIndexSize()));
 
 		if (prim.doubleSided)
 			glEnable(GL_CULL_FACE);
 	}
 	glBindVertexArray(0);
 }
+
+unsigned int Mesh::getIndexType() const { return shortIndices_ ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
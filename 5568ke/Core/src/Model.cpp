@@ -2,6 +2,7 @@
 
 #include "Model.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,41 +12,41 @@
 #include "Mesh.hpp"
 #include "Node.hpp"
 #include "Shader.hpp"
+#include "Texture.hpp"
+
+bool ModelAsset::isResident() const
+{
+	bool meshesReady = std::all_of(meshes.begin(), meshes.end(), [](Mesh const& mesh) { return mesh.getVAO() != 0; });
+	return meshesReady && std::all_of(textures.begin(), textures.end(), [](auto const& texture) { return texture->id != 0; });
+}
 
 Model::~Model() { cleanup(); }
 
 void Model::draw(Shader const& shader, glm::mat4 const& modelMatrix) const
 {
 	// Set the model matrix
-	shader.sendMat4("model", modelMatrix);
+	auto modelUniform = shader.getUniform<glm::mat4>("model");
+	shader.send(modelUniform, modelMatrix);
 
-	// For skinned models, send joint matrices to shader
-	if (!jointMatrices.empty() && animations.size() > 0) {
-		// Enable skinning
-		shader.sendBool("enableSkinning", true);
+	if (!asset)
+		return;
 
-		// Send joint matrices to shader
-		for (size_t i = 0; i < jointMatrices.size() && i < 100; i++) {
-			std::string uniformName = "jointMatrices[" + std::to_string(i) + "]";
-			shader.sendMat4(uniformName.c_str(), jointMatrices[i]);
-		}
-	}
-	else {
-		// Disable skinning for static meshes
-		shader.sendBool("enableSkinning", false);
-	}
+	// No joint palette is bound outside the RenderQueue
+	shader.sendBool("enableSkinning", false);
 
 	// Handle each mesh
+	std::vector<Mesh> const& meshes = asset->meshes;
+	std::vector<int> const& meshNodeIndices = asset->meshNodeIndices;
 	for (size_t i = 0; i < meshes.size(); i++) {
 		glm::mat4 finalTransform = modelMatrix;
 
 		// If this is a static mesh and has a node associated with it
 		if (i < meshNodeIndices.size()) {
 			int nodeIndex = meshNodeIndices[i];
-			if (nodeIndex >= 0 && static_cast<std::size_t>(nodeIndex) < nodes.size() && nodes[nodeIndex]) {
+			if (nodeIndex >= 0 && static_cast<std::size_t>(nodeIndex) < globalMatrices.size()) {
 				// Apply node's transform to the model matrix
-				finalTransform = modelMatrix * nodes[nodeIndex]->getNodeMatrix();
-				shader.sendMat4("model", finalTransform);
+				finalTransform = modelMatrix * globalMatrices[nodeIndex];
+				shader.send(modelUniform, finalTransform);
 			}
 		}
 
@@ -56,21 +57,102 @@ void Model::draw(Shader const& shader, glm::mat4 const& modelMatrix) const
 
 void Model::cleanup()
 {
-	// Clean up any dynamically allocated resources
-	meshes.clear();
-	boundingBoxes.clear();
+	// Release this instance, the asset is freed with its last instance
+	asset.reset();
+	nodes.clear();
+	rootNode.reset();
+}
+
+std::shared_ptr<Model> Model::createInstance() const
+{
+	auto instance = std::make_shared<Model>();
+	instance->asset = asset;
+	instance->modelName = modelName;
+	instance->localSpaceBBox = localSpaceBBox;
+
+	// Copy the nodes, then point the children at the copies
+	instance->nodes.resize(nodes.size());
+	for (std::size_t i = 0; i < nodes.size(); ++i) {
+		if (nodes[i])
+			instance->nodes[i] = std::make_shared<Node>(*nodes[i]);
+	}
+	for (auto const& node : instance->nodes) {
+		if (!node)
+			continue;
+		for (auto& child : node->children) {
+			if (child && child->nodeNum >= 0 && static_cast<std::size_t>(child->nodeNum) < instance->nodes.size())
+				child = instance->nodes[child->nodeNum];
+		}
+	}
+	if (rootNode && rootNode->nodeNum >= 0 && static_cast<std::size_t>(rootNode->nodeNum) < instance->nodes.size())
+		instance->rootNode = instance->nodes[rootNode->nodeNum];
+
+	instance->localMatrices.assign(nodes.size(), glm::mat4(1.0f));
+	instance->globalMatrices.assign(nodes.size(), glm::mat4(1.0f));
+	instance->jointMatrices.assign(jointMatrices.size(), glm::mat4(1.0f));
+	instance->dualQuaternionSkinning_ = dualQuaternionSkinning_;
+	instance->updatePose();
+	return instance;
 }
 
 // Support animation functionality
-void Model::updateLocalMatrices()
+void Model::applyAnimationFrame(int clipIndex, float time, AnimationCursor* cursor)
 {
-	if (!rootNode) {
+	if (!asset || clipIndex < 0 || static_cast<std::size_t>(clipIndex) >= asset->animations.size() || !asset->animations[clipIndex])
+		return;
+
+	if (clipIndex == appliedClip_ && time == appliedTime_)
 		return;
-	}
+
+	asset->animations[clipIndex]->setAnimationFrame(nodes, time, cursor);
+	markPoseDirty();
+	appliedClip_ = clipIndex;
+	appliedTime_ = time;
+}
+
+void Model::markPoseDirty()
+{
+	dirtyStages_ = POSE_ALL;
+	appliedClip_ = -1;
+}
+
+unsigned Model::updatePose()
+{
+	unsigned stages = dirtyStages_;
+	if (stages == 0)
+		return 0;
 
 	// std::cout << "[Model] Updating matrices" << std::endl;
-	NodeUtil::updateNodeListLocalTRSMatrix(nodes);
-	NodeUtil::updateNodeTreeMatricesRecursive(rootNode, glm::mat4(1.0f));
-	NodeUtil::updateNodeListJointMatrices(*this);
-	BBoxUtil::updateLocalBBox(*this);
+	if (stages & POSE_LOCAL)
+		NodeUtil::updateNodeListLocalTRSMatrix(*this);
+	if (stages & POSE_GLOBAL)
+		NodeUtil::updateNodeListGlobalMatrix(*this);
+	if (stages & POSE_JOINTS) {
+		NodeUtil::updateNodeListJointMatrices(*this);
+		if (dualQuaternionSkinning_)
+			NodeUtil::updateNodeListJointDualQuaternions(*this);
+	}
+	if (stages & POSE_BOUNDS)
+		BBoxUtil::updateLocalBBox(*this);
+
+	dirtyStages_ = 0;
+	return stages;
+}
+
+void Model::setDualQuaternionSkinning(bool enabled)
+{
+	if (enabled == dualQuaternionSkinning_)
+		return;
+
+	// The renderer picks the shader by whether the dual quaternions are filled, so they are dropped right away
+	dualQuaternionSkinning_ = enabled;
+	if (!enabled)
+		jointDualQuaternions.clear();
+	dirtyStages_ |= POSE_JOINTS | POSE_BOUNDS;
+}
+
+void Model::updateLocalMatrices()
+{
+	dirtyStages_ = POSE_ALL;
+	updatePose();
 }
@@ -2,52 +2,83 @@
 
 #include "Node.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/dual_quaternion.hpp>
 
 #include "Model.hpp"
 
 namespace NodeUtil {
-void updateNodeTreeMatricesRecursive(std::shared_ptr<Node> node, glm::mat4 const& parentMatrix)
+void buildNodeHierarchy(Model& model)
 {
-	if (!node) {
+	model.asset->nodeOrder.clear();
+	model.asset->nodeOrderParents.clear();
+	model.localMatrices.assign(model.nodes.size(), glm::mat4(1.0f));
+	model.globalMatrices.assign(model.nodes.size(), glm::mat4(1.0f));
+
+	if (!model.rootNode)
 		return;
+
+	// Breadth first, so every node is listed after its parent
+	model.asset->nodeOrder.push_back(model.rootNode->nodeNum);
+	model.asset->nodeOrderParents.push_back(-1);
+
+	for (std::size_t i = 0; i < model.asset->nodeOrder.size(); ++i) {
+		int nodeIndex = model.asset->nodeOrder[i];
+		for (auto const& child : model.nodes[nodeIndex]->children) {
+			if (!child)
+				continue;
+			model.asset->nodeOrder.push_back(child->nodeNum);
+			model.asset->nodeOrderParents.push_back(nodeIndex);
+		}
 	}
+}
 
-	// Calculate global matrix
-	node->updateNodeMatrix(parentMatrix);
+void updateNodeListLocalTRSMatrix(Model& model)
+{
+	for (int nodeIndex : model.asset->nodeOrder)
+		model.localMatrices[nodeIndex] = model.nodes[nodeIndex]->getLocalTRSMatrix();
+}
 
-	// Process all children
-	for (auto const& child : node->children) {
-		updateNodeTreeMatricesRecursive(child, node->getNodeMatrix());
+void updateNodeListGlobalMatrix(Model& model)
+{
+	// Parents precede their children, so the parent's global matrix is always ready
+	for (std::size_t i = 0; i < model.asset->nodeOrder.size(); ++i) {
+		int nodeIndex = model.asset->nodeOrder[i];
+		int parentIndex = model.asset->nodeOrderParents[i];
+
+		if (parentIndex < 0)
+			model.globalMatrices[nodeIndex] = model.localMatrices[nodeIndex];
+		else
+			model.globalMatrices[nodeIndex] = model.globalMatrices[parentIndex] * model.localMatrices[nodeIndex];
 	}
 }
 
-void updateNodeListLocalTRSMatrix(std::vector<std::shared_ptr<Node>> const& nodes)
+void updateNodeListJointMatrices(Model& model)
 {
-	for (auto const& node : nodes) {
-		if (node) {
-			node->updateLocalTRSMatrix();
-		}
+	// Update the joint matrices, a node used by several skins fills one palette entry per skin
+	std::vector<int> const& jointNodes = model.asset->jointNodes;
+	std::size_t jointCount = std::min({jointNodes.size(), model.jointMatrices.size(), model.asset->inverseBindMatrices.size()});
+	for (std::size_t jointIndex = 0; jointIndex < jointCount; ++jointIndex) {
+		int nodeIndex = jointNodes[jointIndex];
+		if (nodeIndex >= 0 && static_cast<std::size_t>(nodeIndex) < model.globalMatrices.size())
+			model.jointMatrices[jointIndex] = model.globalMatrices[nodeIndex] * model.asset->inverseBindMatrices[jointIndex];
 	}
 }
 
-void updateNodeListJointMatrices(Model& model)
+void updateNodeListJointDualQuaternions(Model& model)
 {
-	// Update the joint matrices
-	for (auto const& node : model.nodes) {
-		if (!node)
-			continue;
-
-		int nodeIndex = node->nodeNum;
-		if (nodeIndex < model.nodeToJointMapping.size()) {
-			int jointIndex = model.nodeToJointMapping[nodeIndex];
-			if (jointIndex >= 0 && static_cast<std::size_t>(jointIndex) < model.jointMatrices.size() &&
-					static_cast<std::size_t>(jointIndex) < model.inverseBindMatrices.size()) {
-				model.jointMatrices[jointIndex] = node->getNodeMatrix() * model.inverseBindMatrices[jointIndex];
-			}
-		}
+	model.jointDualQuaternions.resize(model.jointMatrices.size());
+	for (std::size_t jointIndex = 0; jointIndex < model.jointMatrices.size(); ++jointIndex) {
+		glm::mat4 const& m = model.jointMatrices[jointIndex];
+
+		// Normalized axes drop the scale, a dual quaternion only holds rotation and translation
+		glm::mat3 rotation(glm::normalize(glm::vec3(m[0])), glm::normalize(glm::vec3(m[1])), glm::normalize(glm::vec3(m[2])));
+		glm::dualquat dq(glm::normalize(glm::quat_cast(rotation)), glm::vec3(m[3]));
+		model.jointDualQuaternions[jointIndex] =
+				glm::mat2x4(glm::vec4(dq.real.x, dq.real.y, dq.real.z, dq.real.w), glm::vec4(dq.dual.x, dq.dual.y, dq.dual.z, dq.dual.w));
 	}
 }
 
@@ -56,7 +87,7 @@ std::shared_ptr<Node> createRoot(int nodeNum) { return std::make_shared<Node>(no
 
 Node::Node(int nodeNum) : nodeNum(nodeNum) {}
 
-void Node::updateLocalTRSMatrix()
+glm::mat4 Node::getLocalTRSMatrix() const
 {
 	// Create transform = T * R * S
 	glm::mat4 translationMatrix = glm::translate(glm::mat4(1.0f), translation);
@@ -64,25 +95,5 @@ void Node::updateLocalTRSMatrix()
 	glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), scale);
 
 	// Correct transformation order: first scale, then rotate, then translate
-	localTRSMatrix_ = translationMatrix * rotationMatrix * scaleMatrix;
-
-	// Debug log for non-identity matrices
-	if (glm::length(translation) > 0.01f || std::abs(glm::length(rotation) - 1.0f) > 0.01f || glm::length(scale - glm::vec3(1.0f)) > 0.01f) {
-		// std::cout << "[Node INFO] Node " << nodeNum << " local matrix updated: "
-		// << "T(" << translation.x << "," << translation.y << "," << translation.z << ") "
-		// << "R(" << rotation.w << "," << rotation.x << "," << rotation.y << "," << rotation.z << ") "
-		// << "S(" << scale.x << "," << scale.y << "," << scale.z << ")" << std::endl;
-	}
-}
-
-void Node::updateNodeMatrix(glm::mat4 const& parentMatrix)
-{
-	// Multiply parent matrix by local matrix to get global matrix
-	nodeMatrix_ = parentMatrix * localTRSMatrix_;
-
-	// Debug log the result if it's significantly different from identity
-	glm::vec3 position = glm::vec3(nodeMatrix_[3]);
-	if (glm::length(position) > 0.01f) {
-		// std::cout << "[Node INFO] Node " << nodeNum << " local space position: " << position.x << ", " << position.y << ", " << position.z << std::endl;
-	}
+	return translationMatrix * rotationMatrix * scaleMatrix;
 }
@@ -0,0 +1,309 @@
+#include "PoseBlender.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "AnimationClip.hpp"
+#include "Model.hpp"
+#include "Node.hpp"
+
+namespace {
+// Normalized lerp in the hemisphere of a, close enough to slerp for the angles between two poses
+glm::quat nlerp(glm::quat const& a, glm::quat b, float t)
+{
+	if (glm::dot(a, b) < 0.0f)
+		b = -b;
+	return glm::normalize(a * (1.0f - t) + b * t);
+}
+
+void blendPoses(Pose& dst, Pose const& src, float weight, float const* mask)
+{
+	for (std::size_t i = 0; i < dst.size(); ++i) {
+		float w = mask ? weight * mask[i] : weight;
+		if (w <= 0.0f)
+			continue;
+		dst.translations[i] = glm::mix(dst.translations[i], src.translations[i], w);
+		dst.rotations[i] = nlerp(dst.rotations[i], src.rotations[i], w);
+		dst.scales[i] = glm::mix(dst.scales[i], src.scales[i], w);
+	}
+}
+
+// Adds the change from reference to src, the rotation difference is applied in the local space of the node
+void addPoses(Pose& dst, Pose const& src, Pose const& reference, float weight, float const* mask)
+{
+	glm::quat const identity(1.0f, 0.0f, 0.0f, 0.0f);
+	for (std::size_t i = 0; i < dst.size(); ++i) {
+		float w = mask ? weight * mask[i] : weight;
+		if (w <= 0.0f)
+			continue;
+
+		dst.translations[i] += (src.translations[i] - reference.translations[i]) * w;
+
+		glm::quat delta = glm::conjugate(reference.rotations[i]) * src.rotations[i];
+		dst.rotations[i] = glm::normalize(dst.rotations[i] * nlerp(identity, delta, w));
+
+		glm::vec3 ratio(1.0f);
+		for (int c = 0; c < 3; ++c) {
+			if (std::abs(reference.scales[i][c]) > 1e-6f)
+				ratio[c] = src.scales[i][c] / reference.scales[i][c];
+		}
+		dst.scales[i] *= glm::mix(glm::vec3(1.0f), ratio, w);
+	}
+}
+
+AnimationClip const* findClip(Model const& model, int clipIndex)
+{
+	if (!model.asset || clipIndex < 0 || static_cast<std::size_t>(clipIndex) >= model.asset->animations.size())
+		return nullptr;
+	return model.asset->animations[clipIndex].get();
+}
+} // namespace
+
+void PoseBlender::crossfade(int clipIndex, float duration, float startTime, float speed, bool loop)
+{
+	dirty_ = true;
+
+	// The slot already holding the clip keeps its time, otherwise a free slot, otherwise the one contributing least
+	int target = -1;
+	for (int i = 0; i < k_maxFadingClips && target < 0; ++i) {
+		if (fading_[i].clipIndex == clipIndex)
+			target = i;
+	}
+	if (target < 0) {
+		target = 0;
+		for (int i = 0; i < k_maxFadingClips; ++i) {
+			if (fading_[i].clipIndex < 0) {
+				target = i;
+				break;
+			}
+			if (fading_[i].weight < fading_[target].weight)
+				target = i;
+		}
+		fading_[target].clipIndex = clipIndex;
+		fading_[target].time = startTime;
+		fading_[target].weight = 0.0f;
+	}
+
+	ClipState& state = fading_[target];
+	state.speed = speed;
+	state.loop = loop;
+	newest_ = target;
+
+	if (duration <= 0.0f) {
+		for (ClipState& other : fading_) {
+			other.clipIndex = -1;
+			other.weight = 0.0f;
+			other.fadeRate = 0.0f;
+		}
+		state.clipIndex = clipIndex;
+		state.weight = 1.0f;
+		return;
+	}
+
+	float rate = 1.0f / duration;
+	for (ClipState& other : fading_) {
+		if (other.clipIndex >= 0)
+			other.fadeRate = -rate;
+	}
+	state.fadeRate = state.weight < 1.0f ? rate : 0.0f;
+}
+
+void PoseBlender::setLayer(int layer, int clipIndex, LayerMode mode, float weight, std::vector<float> mask, float speed)
+{
+	if (layer < 0 || layer >= k_maxLayers)
+		return;
+
+	Layer& l = layers_[layer];
+	l.clip.clipIndex = clipIndex;
+	l.clip.time = 0.0f;
+	l.clip.speed = speed;
+	l.clip.loop = true;
+	l.clip.weight = std::max(weight, 0.0f);
+	l.mode = mode;
+	l.mask = std::move(mask);
+	l.referenceReady = false;
+	dirty_ = true;
+}
+
+void PoseBlender::setLayerWeight(int layer, float weight)
+{
+	if (layer < 0 || layer >= k_maxLayers)
+		return;
+	layers_[layer].clip.weight = std::max(weight, 0.0f);
+	dirty_ = true;
+}
+
+void PoseBlender::clearLayer(int layer)
+{
+	if (layer < 0 || layer >= k_maxLayers)
+		return;
+	layers_[layer].clip.clipIndex = -1;
+	layers_[layer].clip.weight = 0.0f;
+	dirty_ = true;
+}
+
+void PoseBlender::reset()
+{
+	for (ClipState& state : fading_) {
+		state.clipIndex = -1;
+		state.weight = 0.0f;
+		state.fadeRate = 0.0f;
+	}
+	for (int i = 0; i < k_maxLayers; ++i)
+		clearLayer(i);
+	newest_ = -1;
+	model_ = nullptr;
+	dirty_ = true;
+}
+
+bool PoseBlender::update(Model const& model, float dt)
+{
+	bool changed = dirty_;
+
+	for (ClipState& state : fading_) {
+		if (state.clipIndex < 0)
+			continue;
+
+		advance_(model, state, dt);
+		changed = changed || state.speed != 0.0f;
+
+		if (state.fadeRate == 0.0f)
+			continue;
+		changed = true;
+		state.weight += state.fadeRate * dt;
+		if (state.weight >= 1.0f) {
+			state.weight = 1.0f;
+			state.fadeRate = 0.0f;
+		}
+		else if (state.weight <= 0.0f) {
+			state.clipIndex = -1;
+			state.weight = 0.0f;
+			state.fadeRate = 0.0f;
+		}
+	}
+
+	for (Layer& layer : layers_) {
+		if (layer.clip.clipIndex < 0 || layer.clip.weight <= 0.0f)
+			continue;
+		advance_(model, layer.clip, dt);
+		changed = changed || layer.clip.speed != 0.0f;
+	}
+
+	return changed;
+}
+
+void PoseBlender::apply(Model& model)
+{
+	bind_(model);
+
+	// Base pose, the running weight sum keeps the crossfade weights normalized
+	result_ = restPose_;
+	float total = 0.0f;
+	for (ClipState& state : fading_) {
+		if (state.clipIndex < 0 || state.weight <= 0.0f)
+			continue;
+		sample_(model, state, scratch_);
+		total += state.weight;
+		blendPoses(result_, scratch_, state.weight / total, nullptr);
+	}
+
+	for (Layer& layer : layers_) {
+		if (layer.clip.clipIndex < 0 || layer.clip.weight <= 0.0f)
+			continue;
+
+		if (layer.mode == LayerMode::Additive && !layer.referenceReady) {
+			ClipState first = layer.clip;
+			first.time = 0.0f;
+			sample_(model, first, layer.reference);
+			layer.referenceReady = true;
+		}
+
+		sample_(model, layer.clip, scratch_);
+		float const* mask = layer.mask.size() == result_.size() ? layer.mask.data() : nullptr;
+		if (layer.mode == LayerMode::Additive)
+			addPoses(result_, scratch_, layer.reference, layer.clip.weight, mask);
+		else
+			blendPoses(result_, scratch_, layer.clip.weight, mask);
+	}
+
+	for (std::size_t i = 0; i < model.nodes.size(); ++i) {
+		if (!model.nodes[i])
+			continue;
+		Node& node = *model.nodes[i];
+		node.translation = result_.translations[i];
+		node.rotation = result_.rotations[i];
+		node.scale = result_.scales[i];
+	}
+	model.markPoseDirty();
+	dirty_ = false;
+}
+
+int PoseBlender::getClip() const { return newest_ >= 0 ? fading_[newest_].clipIndex : -1; }
+
+float PoseBlender::getTime() const { return newest_ >= 0 ? fading_[newest_].time : 0.0f; }
+
+bool PoseBlender::isFading() const
+{
+	return std::any_of(fading_.begin(), fading_.end(), [](ClipState const& state) { return state.fadeRate != 0.0f; });
+}
+
+std::vector<float> PoseBlender::buildMask(Model const& model, int rootNode)
+{
+	std::vector<float> mask(model.nodes.size(), 0.0f);
+	if (rootNode < 0 || static_cast<std::size_t>(rootNode) >= model.nodes.size() || !model.nodes[rootNode])
+		return mask;
+
+	std::vector<Node const*> stack{model.nodes[rootNode].get()};
+	while (!stack.empty()) {
+		Node const* node = stack.back();
+		stack.pop_back();
+		if (node->nodeNum >= 0 && static_cast<std::size_t>(node->nodeNum) < mask.size())
+			mask[node->nodeNum] = 1.0f;
+		for (auto const& child : node->children) {
+			if (child)
+				stack.push_back(child.get());
+		}
+	}
+	return mask;
+}
+
+void PoseBlender::bind_(Model const& model)
+{
+	if (model_ == &model && restPose_.size() == model.nodes.size())
+		return;
+
+	// The pose of the nodes right now stands in for the nodes no clip animates
+	model_ = &model;
+	restPose_.resize(model.nodes.size());
+	for (std::size_t i = 0; i < model.nodes.size(); ++i) {
+		Node const* node = model.nodes[i].get();
+		restPose_.translations[i] = node ? node->translation : glm::vec3(0.0f);
+		restPose_.rotations[i] = node ? node->rotation : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		restPose_.scales[i] = node ? node->scale : glm::vec3(1.0f);
+	}
+	scratch_ = restPose_;
+	result_ = restPose_;
+	for (Layer& layer : layers_)
+		layer.referenceReady = false;
+}
+
+void PoseBlender::sample_(Model const& model, ClipState& state, Pose& out)
+{
+	// Same size as the rest pose after bind_, so the copy reuses the buffers
+	out = restPose_;
+	if (AnimationClip const* clip = findClip(model, state.clipIndex))
+		clip->samplePose(out, state.time, &state.cursor);
+}
+
+void PoseBlender::advance_(Model const& model, ClipState& state, float dt) const
+{
+	AnimationClip const* clip = findClip(model, state.clipIndex);
+	float duration = clip ? clip->getDuration() : 0.0f;
+	state.time += dt * state.speed;
+	if (duration <= 0.0f)
+		state.time = 0.0f;
+	else if (state.loop)
+		state.time = state.time - std::floor(state.time / duration) * duration;
+	else
+		state.time = std::clamp(state.time, 0.0f, duration);
+}
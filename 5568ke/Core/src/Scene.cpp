@@ -108,37 +108,27 @@ Scene& Scene::getInstance()
 // Scene methods implementation for camera setup
 void Scene::setupCameraToViewScene(float padding)
 {
-	if (gameObjects.empty()) {
+	if (spatialIndex.empty()) {
 		cam.pos = glm::vec3(0.0f, 1.6f, 3.0f);
 		return;
 	}
 
-	// Find the global bounds of all entities
+	// Tight world boxes of the visible objects in the BVH, the root box is fattened and includes hidden objects
 	BoundingBox worldBounds;
 	worldBounds.min = glm::vec3(std::numeric_limits<float>::max());
 	worldBounds.max = glm::vec3(std::numeric_limits<float>::lowest());
-
-	for (auto const& goPtr : gameObjects) {
-		if (!goPtr || !goPtr->visible || !goPtr->getModel())
-			continue;
-
-		GameObject& gameObject = *goPtr;
-		BoundingBox local = gameObject.getModel()->localSpaceBBox;
-
-		// 8 corner
-		glm::vec3 corners[8] = {
-				{local.min.x, local.min.y, local.min.z}, {local.max.x, local.min.y, local.min.z}, {local.min.x, local.max.y, local.min.z},
-				{local.max.x, local.max.y, local.min.z}, {local.min.x, local.min.y, local.max.z}, {local.max.x, local.min.y, local.max.z},
-				{local.min.x, local.max.y, local.max.z}, {local.max.x, local.max.y, local.max.z},
-		};
-
-		glm::mat4 toWorldMatrix = gameObject.getTransform(); // Model matrix of MVP transformation
-
-		for (glm::vec3 c : corners) {
-			glm::vec3 wp = glm::vec3(toWorldMatrix * glm::vec4(c, 1.0f));
-			worldBounds.min = glm::min(worldBounds.min, wp);
-			worldBounds.max = glm::max(worldBounds.max, wp);
+	bool anyVisible = false;
+	queryBBox(spatialIndex.getRootBBox(), [&](GameObject const& gameObject) {
+		if (gameObject.visible) {
+			worldBounds.min = glm::min(worldBounds.min, gameObject.worldBBox.min);
+			worldBounds.max = glm::max(worldBounds.max, gameObject.worldBBox.max);
+			anyVisible = true;
 		}
+		return true;
+	});
+	if (!anyVisible) {
+		cam.pos = glm::vec3(0.0f, 1.6f, 3.0f);
+		return;
 	}
 
 	// Calculate scene center and bounding radius
@@ -217,22 +207,51 @@ std::shared_ptr<GameObject> Scene::addGameObject(std::shared_ptr<Model> model)
 	if (!model)
 		return nullptr;
 
-	// create a shared_ptr<GameObject> directly
-	auto gameObject = std::make_shared<GameObject>(model);
+	// create a shared_ptr<GameObject> directly, then register it into the scene
+	// return it so caller can further configure (e.g. set position, callbacks...)
+	return addGameObject(std::make_shared<GameObject>(model));
+}
+
+std::shared_ptr<GameObject> Scene::addGameObject(std::shared_ptr<GameObject> gameObject)
+{
+	if (!gameObject)
+		return nullptr;
 
-	// register into the scene
 	gameObjects.push_back(gameObject);
 
-	// return it so caller can further configure (e.g. set position, callbacks...)
+	// Only objects with a model have a meaningful worldBBox
+	if (gameObject->hasModel() && gameObject->getSpatialProxy() < 0) {
+		int proxyId = spatialIndex.createProxy(gameObject->worldBBox, gameObject.get());
+		gameObject->attachSpatialIndex(&spatialIndex, proxyId);
+		visibleIndexedCount_ += gameObject->visible ? 1 : 0;
+	}
+
 	return gameObject;
 }
 
 // Implementation for removing gameObject
 void Scene::removeGameObject(std::string const& name)
 {
-	gameObjects.erase(std::remove_if(gameObjects.begin(), gameObjects.end(),
-																	 [&](auto const& goPtr) { return goPtr && goPtr->getModel() && goPtr->getModel()->modelName == name; }),
-										gameObjects.end());
+	auto isNamed = [&](auto const& goPtr) { return goPtr && goPtr->getModel() && goPtr->getModel()->modelName == name; };
+
+	for (auto const& goPtr : gameObjects) {
+		if (isNamed(goPtr) && goPtr->getSpatialProxy() >= 0) {
+			spatialIndex.destroyProxy(goPtr->getSpatialProxy());
+			goPtr->attachSpatialIndex(nullptr, -1);
+			visibleIndexedCount_ -= goPtr->visible ? 1 : 0;
+		}
+	}
+
+	gameObjects.erase(std::remove_if(gameObjects.begin(), gameObjects.end(), isNamed), gameObjects.end());
+}
+
+void Scene::setVisible(GameObject& gameObject, bool visible)
+{
+	if (gameObject.visible == visible)
+		return;
+	gameObject.visible = visible;
+	if (gameObject.getSpatialProxy() >= 0)
+		visibleIndexedCount_ += visible ? 1 : -1;
 }
 
 // Implementation for adding light
@@ -250,6 +269,15 @@ size_t Scene::getVisibleGameObjectCount() const
 	return std::count_if(gameObjects.begin(), gameObjects.end(), [](auto const& goPtr) { return goPtr && goPtr->visible; });
 }
 
-// Scene cleanup
-void Scene::cleanup() {}
+// Scene cleanup, the models of the game objects free their GL resources here so it runs while the context is current
+void Scene::cleanup()
+{
+	for (auto const& goPtr : gameObjects) {
+		if (goPtr)
+			goPtr->attachSpatialIndex(nullptr, -1);
+	}
+	gameObjects.clear();
+	spatialIndex.clear();
+	visibleIndexedCount_ = 0;
+}
 Scene::~Scene() { cleanup(); }
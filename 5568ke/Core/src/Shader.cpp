@@ -1,11 +1,15 @@
 #include "Shader.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include "GLStateCache.hpp"
+
 namespace {
 unsigned int compileStage(std::string const& src, GLenum type)
 {
@@ -48,8 +52,10 @@ void Shader::reload()
 	if (vsPath_.empty() || fsPath_.empty())
 		return;
 
-	if (program_)
+	if (program_) {
+		GLStateCache::getInstance().forgetProgram(program_);
 		glDeleteProgram(program_);
+	}
 
 	unsigned int vs = compileStage(loadFile(vsPath_), GL_VERTEX_SHADER);
 	unsigned int fs = compileStage(loadFile(fsPath_), GL_FRAGMENT_SHADER);
@@ -84,44 +90,113 @@ void Shader::reload()
 
 	glDeleteShader(vs);
 	glDeleteShader(fs);
+
+	// GLSL 330 has no layout(binding), so the per-frame block is attached to its binding point here
+	GLuint frameBlock = glGetUniformBlockIndex(program_, k_frameDataBlock);
+	if (frameBlock != GL_INVALID_INDEX)
+		glUniformBlockBinding(program_, frameBlock, k_frameDataBinding);
+
+	reflectUniforms_();
+}
+
+void Shader::reflectUniforms_()
+{
+	uniformLocations_.clear();
+
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<char> nameBuffer(std::max(maxLength, 1));
+
+	for (GLint i = 0; i < count; ++i) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(program_, static_cast<GLuint>(i), maxLength, &length, &size, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), length);
+
+		// Uniforms inside a block have no location
+		int loc = glGetUniformLocation(program_, name.c_str());
+		if (loc == -1)
+			continue;
+
+		// Arrays are reported once as "name[0]", register the bare name and every element
+		if (name.ends_with("[0]")) {
+			std::string base = name.substr(0, name.size() - 3);
+			uniformLocations_[base] = loc;
+			for (GLint e = 0; e < size; ++e) {
+				std::string element = base + '[' + std::to_string(e) + ']';
+				uniformLocations_[element] = glGetUniformLocation(program_, element.c_str());
+			}
+		}
+		else {
+			uniformLocations_[name] = loc;
+		}
+	}
 }
 
-void Shader::bind() const { glUseProgram(program_); }
+void Shader::bind() const { GLStateCache::getInstance().useProgram(program_); }
+
+void Shader::unbind() const { GLStateCache::getInstance().useProgram(0); }
 
-void Shader::unbind() const { glUseProgram(0); }
+int Shader::getUniformLocation(std::string_view name) const
+{
+	auto it = uniformLocations_.find(name);
+	if (it != uniformLocations_.end())
+		return it->second;
+
+	// Only the first miss of a name allocates, optional uniforms are probed every draw
+	uniformLocations_.emplace(name, -1);
+	std::cout << "[Shader] Warning: uniform '" << name << "' not found.\n";
+	return -1;
+}
 
-void Shader::sendMat4(char const* name, glm::mat4 const& mat) const
+void Shader::send(Uniform<glm::mat4> uniform, glm::mat4 const& mat) const
 {
-	int loc = glGetUniformLocation(program_, name);
-	if (loc != -1)
-		glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(mat));
-	else
-		std::cout << "[Shader] Warning: uniform '" << name << "' not found.\n";
+	if (uniform.isValid())
+		glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(mat));
 }
 
-void Shader::sendVec3(char const* name, glm::vec3 const& vec) const
+void Shader::send(Uniform<glm::vec3> uniform, glm::vec3 const& vec) const
 {
-	int loc = glGetUniformLocation(program_, name);
-	if (loc != -1)
-		glUniform3fv(loc, 1, glm::value_ptr(vec));
-	else
-		std::cout << "[Shader] Warning: uniform '" << name << "' not found.\n";
+	if (uniform.isValid())
+		glUniform3fv(uniform.location, 1, glm::value_ptr(vec));
 }
 
-void Shader::sendFloat(char const* name, float value) const
+void Shader::send(Uniform<float> uniform, float value) const
 {
-	int loc = glGetUniformLocation(program_, name);
-	if (loc != -1)
-		glUniform1f(loc, value);
-	else
-		std::cout << "[Shader] Warning: uniform '" << name << "' not found.\n";
+	if (uniform.isValid())
+		glUniform1f(uniform.location, value);
 }
 
-void Shader::sendInt(char const* name, int value) const
+void Shader::send(Uniform<int> uniform, int value) const
 {
-	int loc = glGetUniformLocation(program_, name);
-	if (loc != -1)
-		glUniform1i(loc, value);
-	else
-		std::cout << "[Shader] Warning: uniform '" << name << "' not found.\n";
+	if (uniform.isValid())
+		glUniform1i(uniform.location, value);
 }
+
+void Shader::send(Uniform<bool> uniform, bool value) const
+{
+	if (uniform.isValid())
+		glUniform1i(uniform.location, static_cast<int>(value));
+}
+
+void Shader::sendMat4(char const* name, glm::mat4 const& mat) const { send(getUniform<glm::mat4>(name), mat); }
+
+void Shader::sendVec3(char const* name, glm::vec3 const& vec) const { send(getUniform<glm::vec3>(name), vec); }
+
+void Shader::sendFloat(char const* name, float value) const { send(getUniform<float>(name), value); }
+
+void Shader::sendInt(char const* name, int value) const { send(getUniform<int>(name), value); }
+
+void Shader::sendBool(char const* name, bool value) const { send(getUniform<bool>(name), value); }
+
+void Shader::sendMat4Array(char const* name, glm::mat4 const* mats, int count) const
+{
+	int loc = getUniformLocation(name);
+	if (loc != -1 && count > 0)
+		glUniformMatrix4fv(loc, count, GL_FALSE, glm::value_ptr(mats[0]));
+}
+
+void Shader::sendSampler(char const* name, int unit) const { GLStateCache::getInstance().setSampler(program_, getUniformLocation(name), unit); }
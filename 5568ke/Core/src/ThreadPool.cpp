@@ -0,0 +1,121 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool()
+{
+	// One core is left to the main thread, hardware_concurrency() may also return 0 when unknown
+	unsigned int hc = std::thread::hardware_concurrency();
+	unsigned int count = hc > 1 ? hc - 1 : 1;
+	workers_.reserve(count);
+	for (unsigned int i = 0; i < count; ++i)
+		workers_.emplace_back([this] { workerLoop_(); });
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard lock(mutex_);
+		if (stopping_)
+			return;
+		tasks_.push_back(std::move(task));
+	}
+	taskReady_.notify_one();
+}
+
+void ThreadPool::waitIdle()
+{
+	std::unique_lock lock(mutex_);
+	idle_.wait(lock, [this] { return tasks_.empty() && activeTasks_ == 0; });
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> const& fn)
+{
+	grain = std::max<std::size_t>(grain, 1);
+	std::size_t chunkCount = (count + grain - 1) / grain;
+	if (chunkCount == 0)
+		return;
+
+	std::lock_guard serial(loopMutex_);
+	{
+		std::lock_guard lock(mutex_);
+		loop_.fn = &fn;
+		loop_.count = count;
+		loop_.grain = grain;
+		loop_.chunkCount = chunkCount;
+		loop_.nextChunk = 0;
+		loop_.helpersWanted = std::min(workers_.size(), chunkCount - 1);
+	}
+	taskReady_.notify_all();
+
+	runLoopChunks_();
+
+	// Every chunk was taken by this thread or by a helper still registered, once no helper is left they all ran.
+	// Workers that did not get to join in time are turned away, the state is reused by the next call
+	std::unique_lock lock(mutex_);
+	loop_.helpersWanted = 0;
+	loopDone_.wait(lock, [this] { return loop_.helpersActive == 0; });
+	loop_.fn = nullptr;
+}
+
+void ThreadPool::runLoopChunks_()
+{
+	for (std::size_t chunk = loop_.nextChunk++; chunk < loop_.chunkCount; chunk = loop_.nextChunk++) {
+		std::size_t begin = chunk * loop_.grain;
+		(*loop_.fn)(begin, std::min(begin + loop_.grain, loop_.count));
+	}
+}
+
+void ThreadPool::shutdown()
+{
+	{
+		std::lock_guard lock(mutex_);
+		if (stopping_)
+			return;
+		stopping_ = true;
+		tasks_.clear();
+	}
+	taskReady_.notify_all();
+	idle_.notify_all();
+
+	for (auto& worker : workers_)
+		worker.join();
+	workers_.clear();
+}
+
+void ThreadPool::workerLoop_()
+{
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock lock(mutex_);
+			taskReady_.wait(lock, [this] { return stopping_ || loop_.helpersWanted > 0 || !tasks_.empty(); });
+			if (stopping_)
+				return;
+
+			// Help with a running parallelFor first, the frame is waiting on it
+			if (loop_.helpersWanted > 0) {
+				loop_.helpersWanted--;
+				loop_.helpersActive++;
+				lock.unlock();
+				runLoopChunks_();
+				lock.lock();
+				if (--loop_.helpersActive == 0)
+					loopDone_.notify_all();
+				continue;
+			}
+
+			task = std::move(tasks_.front());
+			tasks_.pop_front();
+			activeTasks_++;
+		}
+
+		task();
+
+		{
+			std::lock_guard lock(mutex_);
+			activeTasks_--;
+		}
+		idle_.notify_all();
+	}
+}
@@ -60,8 +60,15 @@ private:
 	int selectedGameObjectIndex_{};
 	int selectedClipIndex_{-1};
 
+	// Stress test state, every copy is named k_stressCopyName so they are removed together
+	static constexpr char const* k_stressCopyName = "stress_copy";
+	int stressCopyCount_{1000};
+	float stressSpacing_{2.0f};
+	int stressCopies_{};
+
 	// Utility functions
 	void loadSelectedModel_(Scene& scene);
 	void drawTransformEditor_(GameObject& gameObject);
 	void drawNodeTree_(std::shared_ptr<Node> node, int depth);
+	void spawnStressCopies_(Scene& scene, GameObject const& source);
 };
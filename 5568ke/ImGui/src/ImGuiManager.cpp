@@ -3,6 +3,7 @@
 #include "ImGuiManager.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 
@@ -12,10 +13,14 @@
 #include <glm/gtx/quaternion.hpp>
 
 #include "AnimationClip.hpp"
+#include "AnimationSystem.hpp"
 #include "Collider.hpp"
 #include "ImGuiFileDialog.h"
+#include "Mesh.hpp"
+#include "MeshSimplifier.hpp"
 #include "Model.hpp"
 #include "Node.hpp"
+#include "TextureCache.hpp"
 
 ImGuiManager& ImGuiManager::getInstance()
 {
@@ -206,7 +211,7 @@ void ImGuiManager::drawSceneGameObjectManager(Scene& scene)
 		// Visibility toggle
 		bool visible = gameObject.visible;
 		if (ImGui::Checkbox("Visible", &visible)) {
-			gameObject.visible = visible;
+			scene.setVisible(gameObject, visible);
 		}
 
 		// Remove gameObject buttonS
@@ -226,6 +231,33 @@ void ImGuiManager::drawSceneGameObjectManager(Scene& scene)
 		// Transform editor
 		if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen))
 			drawTransformEditor_(gameObject);
+
+		// Dual quaternion skinning keeps the volume of twisted joints, linear blend collapses them
+		Model& model = *gameObject.getModel();
+		if (!model.jointMatrices.empty()) {
+			bool dualQuat = model.usesDualQuaternionSkinning();
+			if (ImGui::Checkbox("Dual Quaternion Skinning", &dualQuat))
+				model.setDualQuaternionSkinning(dualQuat);
+		}
+
+		// Vertex cache efficiency of every mesh, ACMR is vertex shader runs per triangle (lower is better)
+		if (ImGui::CollapsingHeader("Meshes")) {
+			auto const& meshes = gameObject.getModel()->asset->meshes;
+			for (std::size_t i = 0; i < meshes.size(); ++i) {
+				Mesh const& mesh = meshes[i];
+				// Triangles per level of detail, summed over the primitives
+				unsigned int lodTriangles[1 + MeshSimplifier::k_maxLods]{};
+				for (Primitive const& prim : mesh.primitives) {
+					for (int lod = 0; lod <= MeshSimplifier::k_maxLods; ++lod) {
+						std::size_t level = std::min<std::size_t>(lod, prim.lods.size());
+						lodTriangles[lod] += (level == 0 ? prim.indexCount : prim.lods[level - 1].indexCount) / 3;
+					}
+				}
+				ImGui::Text("Mesh %zu: %zu vertices, %u triangles, %zu bit indices", i, mesh.vertices.size(), lodTriangles[0], mesh.getIndexSize() * 8);
+				ImGui::Text("  ACMR %.3f -> %.3f", mesh.acmrSource, mesh.acmr);
+				ImGui::Text("  LOD triangles %u/%u/%u", lodTriangles[1], lodTriangles[2], lodTriangles[3]);
+			}
+		}
 	}
 
 	// Show bone hierarchy
@@ -282,9 +314,50 @@ void ImGuiManager::drawSceneGameObjectManager(Scene& scene)
 		}
 	}
 
+	// Stress test section, fills the scene with copies of the selected game object to compare the draw calls with and without instancing
+	if (ImGui::CollapsingHeader("Stress Test")) {
+		ImGui::SliderInt("Copies", &stressCopyCount_, 100, 5000);
+		ImGui::DragFloat("Spacing", &stressSpacing_, 0.1f, 0.1f, 100.0f);
+
+		bool hasSelection = selectedGameObjectIndex_ >= 0 && static_cast<std::size_t>(selectedGameObjectIndex_) < scene.gameObjects.size();
+		if (ImGui::Button("Spawn Copies Of Selected") && hasSelection)
+			spawnStressCopies_(scene, *scene.gameObjects[selectedGameObjectIndex_]);
+
+		ImGui::SameLine();
+		if (ImGui::Button("Clear Copies") && stressCopies_ > 0) {
+			scene.removeGameObject(k_stressCopyName);
+			stressCopies_ = 0;
+			selectedGameObjectIndex_ = -1;
+		}
+
+		ImGui::Text("Spawned copies: %d", stressCopies_);
+	}
+
 	ImGui::End();
 }
 
+void ImGuiManager::spawnStressCopies_(Scene& scene, GameObject const& source)
+{
+	std::shared_ptr<Model> sourceModel = source.getModel();
+	if (!sourceModel)
+		return;
+
+	// Copies share the model asset, so every primitive lands in the same instanced batch. No colliders, they only stress the renderer
+	int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(stressCopyCount_))));
+	for (int i = 0; i < stressCopyCount_; ++i) {
+		std::shared_ptr<Model> copy = sourceModel->createInstance();
+		copy->modelName = k_stressCopyName;
+
+		auto goPtr = scene.addGameObject(copy);
+		goPtr->position = source.position + glm::vec3((i % side) * stressSpacing_, 0.0f, (i / side) * stressSpacing_);
+		goPtr->rotationDeg = source.rotationDeg;
+		goPtr->scale = source.scale;
+		goPtr->updateTransformMatrix();
+	}
+
+	stressCopies_ += stressCopyCount_;
+}
+
 void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 {
 	ImGui::SetNextWindowSize(ImVec2(400, 350), ImGuiCond_FirstUseEver);
@@ -301,7 +374,7 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 	GameObject& gameObject = *goPtr;
 	Model& model = *gameObject.getModel();
 	ImGui::Text("Selected Model: %s", gameObject.getModel()->modelName.c_str());
-	ImGui::Text("Model has %zu animations", gameObject.getModel()->animations.size());
+	ImGui::Text("Model has %zu animations", gameObject.getModel()->asset->animations.size());
 
 	if (animStateRef.gameObjectName != gameObject.getModel()->modelName) {
 		ImGui::Text("animStateRef.gameObjectName != gameObject.getModel()->modelName");
@@ -311,7 +384,7 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 
 	// Animation clips
 	std::vector<std::string> clipNames;
-	for (auto const& clip : gameObject.getModel()->animations)
+	for (auto const& clip : gameObject.getModel()->asset->animations)
 		clipNames.push_back(clip->clipName);
 
 	if (static_cast<std::size_t>(selectedClipIndex_) >= clipNames.size())
@@ -327,9 +400,8 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 				animStateRef.clipIndex = selectedClipIndex_;
 
 				// Reset animation visually
-				if (model.animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
-					model.animations[selectedClipIndex_]->setAnimationFrame(model.nodes, 0.0f);
-					model.updateLocalMatrices();
+				if (model.asset->animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
+					model.applyAnimationFrame(selectedClipIndex_, 0.0f);
 				}
 			}
 			if (isSelected) {
@@ -350,12 +422,13 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 		if (ImGui::SliderFloat("Speed", &speed, 0.1f, 2.0f)) {
 			animStateRef.setAnimateSpeed(speed);
 		}
+		ImGui::SliderFloat("Crossfade", &animStateRef.crossfadeDuration, 0.0f, 1.0f, "%.2f s");
 	}
 
 	// Get duration
 	float duration = 0.0f;
-	if (model.animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
-		duration = model.animations[selectedClipIndex_]->getDuration();
+	if (model.asset->animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
+		duration = model.asset->animations[selectedClipIndex_]->getDuration();
 	}
 
 	// Time slider
@@ -364,9 +437,8 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 
 		if (ImGui::SliderFloat("Time", &currentTime, 0.0f, duration)) {
 			// Update animation frame if this is the current gameObject
-			if (model.animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
-				model.animations[selectedClipIndex_]->setAnimationFrame(model.nodes, currentTime);
-				model.updateLocalMatrices();
+			if (model.asset->animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
+				model.applyAnimationFrame(selectedClipIndex_, currentTime, &animStateRef.cursor);
 			}
 		}
 	}
@@ -381,9 +453,8 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 		animStateRef.play(selectedClipIndex_);
 
 		// Apply initial frame for visual feedback
-		if (model.animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
-			model.animations[selectedClipIndex_]->setAnimationFrame(model.nodes, 0.0f);
-			model.updateLocalMatrices();
+		if (model.asset->animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
+			model.applyAnimationFrame(selectedClipIndex_, 0.0f);
 		}
 	}
 	ImGui::SameLine();
@@ -413,9 +484,8 @@ void ImGuiManager::drawAnimationControlPanel(Scene& scene)
 		animStateRef.stop();
 
 		// Reset visually
-		if (model.animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
-			model.animations[selectedClipIndex_]->setAnimationFrame(model.nodes, 0.0f);
-			model.updateLocalMatrices();
+		if (model.asset->animations.size() > static_cast<std::size_t>(selectedClipIndex_)) {
+			model.applyAnimationFrame(selectedClipIndex_, 0.0f);
 		}
 	}
 
@@ -511,6 +581,24 @@ void ImGuiManager::drawStatusWindow(Scene& scene)
 	ImGui::Begin("Statistics");
 	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 	ImGui::Text("Scene entities: %zu", scene.gameObjects.size());
+	AnimationSystem::Stats const& animStats = AnimationSystem::getInstance().getStats();
+	ImGui::Text("Pose passes local/global/joint/bounds: %d/%d/%d/%d (%d clean)", animStats.localPasses, animStats.globalPasses, animStats.jointPasses,
+							animStats.boundsPasses, animStats.cleanModels);
+	ImGui::Text("Animation: %d models, %d clips sampled, %d blended in %.3f ms on %d threads", animStats.models, animStats.sampledClips,
+							animStats.blendedModels, animStats.milliseconds, animStats.threads);
+	ImGui::Checkbox("Parallel Animation", &AnimationSystem::getInstance().parallel);
+	ImGui::Text("Entities drawn/culled: %d/%d (%d draw calls)", rendererRef.getFrameStats().visibleEntities, rendererRef.getFrameStats().culledEntities,
+							rendererRef.getFrameStats().drawCalls);
+	ImGui::Text("Instanced draw calls: %d (%d instances)", rendererRef.getFrameStats().instancedDrawCalls, rendererRef.getFrameStats().instances);
+	TextureCache::Stats textureStats = TextureCache::getInstance().getStats();
+	ImGui::Text("Textures: %zu resident (%.1f MB), %zu reused", textureStats.residentTextures, textureStats.residentBytes / (1024.0 * 1024.0), textureStats.hits);
+	ImGui::Text("State changes: %d (%d avoided, %d GL calls skipped)", rendererRef.getFrameStats().stateChanges, rendererRef.getFrameStats().stateChangesAvoided,
+							rendererRef.getFrameStats().redundantGLCallsSkipped);
+	auto const& lodEntities = rendererRef.getFrameStats().lodEntities;
+	ImGui::Text("Triangles submitted: %d (LOD 0/1/2/3 entities %d/%d/%d/%d)", rendererRef.getFrameStats().triangles, lodEntities[0], lodEntities[1],
+							lodEntities[2], lodEntities[3]);
+	ImGui::Text("Joint palette: %d joints, %.1f KB uploaded (%.1f KB as matrices)", rendererRef.getFrameStats().joints,
+							rendererRef.getFrameStats().jointBytes / 1024.0f, rendererRef.getFrameStats().jointMatrixBytes / 1024.0f);
 	ImGui::Text("Press TAB to toggle camera mode");
 	ImGui::Text("F1-F4 to toggle UI windows");
 
@@ -557,6 +645,11 @@ void ImGuiManager::drawSceneControlWindow(Scene& scene)
 
 							ImGui::Separator();
 
+	ImGui::Checkbox("Instanced Static Drawing", &rendererRef.useInstancing);
+	ImGui::Checkbox("Mesh LODs", &rendererRef.useLods);
+	ImGui::SliderFloat("LOD Bias", &rendererRef.lodBias, 0.25f, 4.0f);
+	ImGui::Separator();
+
 	// Camera section
 	if (ImGui::CollapsingHeader("Camera Controls", ImGuiTreeNodeFlags_DefaultOpen)) {
 		// Camera position
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "GLStateCache.hpp"
 #include "include_5568ke.hpp"
 
 #include <string>
@@ -14,7 +15,6 @@ public:
 
 	void bind(unsigned int slot) const
 	{
-		glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTexture(GL_TEXTURE_2D, id);
+		GLStateCache::getInstance().bindTexture2D(slot, id);
 	}
 };
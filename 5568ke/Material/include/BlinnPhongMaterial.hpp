@@ -12,4 +12,7 @@ public:
 	Texture* overlayMap{nullptr};
 
 	void bind(Shader const& shader) const override;
+
+	// 1x1 white texture bound when a material has no texture, owned by the Renderer and created in Renderer::init
+	static inline unsigned int fallbackTexture{0};
 };
@@ -1,4 +1,5 @@
 #include "BlinnPhongMaterial.hpp"
+#include "GLStateCache.hpp"
 #include "Texture.hpp"
 #include "include_5568ke.hpp"
 
@@ -6,40 +7,24 @@ void BlinnPhongMaterial::bind(Shader const& shader) const
 {
 	// The shader doesn't have material.albedo or material.shininess uniforms
 	// It directly uses the texture colors instead
+	// Binds and sampler uniforms already in place are skipped by the state cache
+	GLStateCache& glState = GLStateCache::getInstance();
 
 	// Bind diffuse/base texture to texture unit 0
 	if (diffuseMap) {
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap->id);
-		shader.sendInt("tex0", 0);
+		glState.bindTexture2D(0, diffuseMap->id);
+		shader.sendSampler("tex0", 0);
 	}
 
 	// Bind overlay texture to texture unit 1
 	if (overlayMap) {
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, overlayMap->id);
-		shader.sendInt("tex1", 1);
+		glState.bindTexture2D(1, overlayMap->id);
+		shader.sendSampler("tex1", 1);
 	}
 
-	// If no textures are available, we could potentially add a fallback
-	// by modifying the shader to use a uniform color, but that would require
-	// shader changes. For now, we'll just make sure at least one texture is bound.
-
+	// If no textures are available, bind the white fallback texture so the base color is valid
 	if (!diffuseMap && !overlayMap) {
-		// Create a small white texture as fallback
-		static GLuint defaultTexture = 0;
-		if (defaultTexture == 0) {
-			// Create a default white texture
-			unsigned char whitePixel[4] = {255, 255, 255, 255};
-			glGenTextures(1, &defaultTexture);
-			glBindTexture(GL_TEXTURE_2D, defaultTexture);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		}
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, defaultTexture);
-		shader.sendInt("tex0", 0);
+		glState.bindTexture2D(0, fallbackTexture);
+		shader.sendSampler("tex0", 0);
 	}
 }
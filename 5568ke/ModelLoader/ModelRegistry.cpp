@@ -8,9 +8,11 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "GLUploadQueue.hpp"
 #include "GltfLoader.hpp"
 #include "Model.hpp"
 #include "Scene.hpp"
+#include "ThreadPool.hpp"
 
 // Singleton accessor
 ModelRegistry& ModelRegistry::getInstance()
@@ -24,6 +26,112 @@ ModelRegistry::ModelRegistry() : gltfLoader_(std::make_unique<GltfLoader>()) {}
 
 // Load a model with optional position parameters
 std::shared_ptr<Model> ModelRegistry::loadModel(std::string const& path, std::string const& name)
+{
+	// Reuse the asset when this file was already loaded
+	std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+	std::shared_ptr<Model> prototype;
+	if (auto it = prototypes_.find(key); it != prototypes_.end()) {
+		prototype = it->second;
+	}
+	else {
+		// Detect format from file extension
+		ModelFormat format = detectFormat_(path);
+
+		// Load model based on format
+		switch (format) {
+		case ModelFormat::GLTF:
+			prototype = gltfLoader_->loadModel(path);
+			break;
+		default:
+			// std::cout << "[ModelRegistry ERROR] Unsupported model format" << std::endl;
+			return nullptr;
+		}
+
+		if (prototype)
+			prototypes_[key] = prototype;
+	}
+
+	if (prototype) {
+		// std::cout << "[ModelRegistry] Successfully loaded model '" << path << "'" << std::endl;
+		return makeInstance_(*prototype, path, name);
+	}
+
+	// std::cout << "[ModelRegistry ERROR] Failed to load model '" << path << "'" << std::endl;
+	return nullptr;
+}
+
+void ModelRegistry::loadModelAsync(std::string const& path, std::string const& name, LoadCallback onLoaded)
+{
+	GLUploadQueue& uploadQueue = GLUploadQueue::getInstance();
+	std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+
+	// Already loaded, still answered from update so the callback always runs at the same point of the frame
+	if (auto it = prototypes_.find(key); it != prototypes_.end()) {
+		uploadQueue.push([this, prototype = it->second, path, name, onLoaded] { onLoaded(makeInstance_(*prototype, path, name)); });
+		return;
+	}
+
+	// Join the load of this file when it is already in flight
+	auto [it, inserted] = inFlight_.try_emplace(key);
+	it->second.emplace_back(name, std::move(onLoaded));
+	if (!inserted)
+		return;
+
+	if (detectFormat_(path) != ModelFormat::GLTF) {
+		// std::cout << "[ModelRegistry ERROR] Unsupported model format" << std::endl;
+		uploadQueue.push([this, key, path] { finishAsyncLoad_(key, path, nullptr); });
+		return;
+	}
+
+	// Each task parses with its own copy of the loader, the GL jobs it queues come before the completion job
+	ThreadPool::getInstance().submit([this, key, path, loader = *gltfLoader_]() mutable {
+		std::shared_ptr<Model> prototype = loader.parseModel(path);
+		GLUploadQueue::getInstance().push([this, key, path, prototype] { finishAsyncLoad_(key, path, prototype); });
+	});
+}
+
+void ModelRegistry::update(double budgetMs)
+{
+	GLUploadQueue::getInstance().drain(budgetMs);
+
+	// A load still waiting lands back in waitingLoads_ for the next frame
+	std::swap(waitingLoads_, retryingLoads_);
+	for (WaitingLoad& load : retryingLoads_)
+		finishAsyncLoad_(load.key, load.path, std::move(load.prototype));
+	retryingLoads_.clear();
+}
+
+void ModelRegistry::cleanup()
+{
+	ThreadPool::getInstance().shutdown();
+	GLUploadQueue::getInstance().clear();
+	inFlight_.clear();
+	waitingLoads_.clear();
+	prototypes_.clear();
+}
+
+void ModelRegistry::finishAsyncLoad_(std::string const& key, std::string const& path, std::shared_ptr<Model> prototype)
+{
+	// A texture found in the cache may belong to another load whose upload is still queued, try again next frame.
+	// Pushing the retry into the queue being drained would pop it again and again until the budget is spent
+	if (prototype && !prototype->asset->isResident()) {
+		waitingLoads_.push_back(WaitingLoad{key, path, std::move(prototype)});
+		return;
+	}
+
+	// Keep the prototype of a synchronous load of the same file that finished first
+	if (prototype)
+		prototype = prototypes_.try_emplace(key, prototype).first->second;
+
+	auto node = inFlight_.extract(key);
+	if (node.empty())
+		return;
+
+	for (auto& [name, onLoaded] : node.mapped())
+		onLoaded(prototype ? makeInstance_(*prototype, path, name) : nullptr);
+}
+
+std::string ModelRegistry::makeModelName_(std::string const& path, std::string const& name) const
 {
 	// Use provided name or generate one from path
 	// Since most of the model are called scene.gltf, so we used the folder name that contained the model as the default name.
@@ -37,32 +145,15 @@ std::shared_ptr<Model> ModelRegistry::loadModel(std::string const& path, std::st
 	while (sceneRef.findGameObject(modelName)) {
 		modelName = baseName + '(' + std::to_string(suffix++) + ')';
 	}
+	return modelName;
+}
 
-	// Detect format from file extension
-	ModelFormat format = detectFormat_(path);
-
-	// Load model based on format
-	std::shared_ptr<Model> model;
-	switch (format) {
-	case ModelFormat::GLTF:
-		model = gltfLoader_->loadModel(path);
-		break;
-	default:
-		// std::cout << "[ModelRegistry ERROR] Unsupported model format" << std::endl;
-		return nullptr;
-	}
-
-	if (model) {
-		// Cache the model
-		model->modelName = modelName;
-		model->updateLocalMatrices();
-
-		// std::cout << "[ModelRegistry] Successfully loaded model '" << modelName << "'" << std::endl;
-		return model;
-	}
-
-	// std::cout << "[ModelRegistry ERROR] Failed to load model '" << path << "'" << std::endl;
-	return nullptr;
+std::shared_ptr<Model> ModelRegistry::makeInstance_(Model const& prototype, std::string const& path, std::string const& name) const
+{
+	std::shared_ptr<Model> model = prototype.createInstance();
+	model->modelName = makeModelName_(path, name);
+	model->updatePose();
+	return model;
 }
 
 // Add a model to a scene with a transform matrix
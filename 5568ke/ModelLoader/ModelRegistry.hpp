@@ -1,8 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -28,8 +30,27 @@ public:
 	static ModelRegistry& getInstance();
 
 	// Load a model with optional position parameters
+	// Each file is parsed and uploaded once, every call returns a new instance sharing that data
 	std::shared_ptr<Model> loadModel(std::string const& path, std::string const& name = "");
 
+	// Load a model on the worker threads, 'onLoaded' runs on the GL thread from update once the model can be drawn,
+	// with nullptr when loading failed. Loads of a file already loaded or in flight share its asset
+	using LoadCallback = std::function<void(std::shared_ptr<Model>)>;
+	void loadModelAsync(std::string const& path, std::string const& name, LoadCallback onLoaded);
+
+	// Run the queued GL uploads and load callbacks for up to budgetMs, call once per frame on the GL thread
+	static constexpr double k_uploadBudgetMs = 4.0;
+	void update(double budgetMs = k_uploadBudgetMs);
+
+	// Files still being parsed or uploaded
+	int getPendingLoads() const { return static_cast<int>(inFlight_.size()); }
+
+	// Wait for the workers and drop the queued uploads, call before the GL context is destroyed
+	void cleanup();
+
+	// Forget the loaded files, their assets are freed once no instance uses them anymore
+	void clearCache() { prototypes_.clear(); }
+
 	// Add a model to a scene with a transform matrix
 	std::shared_ptr<GameObject> addModelToScene(Scene& scene, std::shared_ptr<Model> model);
 
@@ -48,4 +69,23 @@ private:
 
 	// Concrete loader instances
 	std::unique_ptr<GltfLoader> gltfLoader_;
+
+	// First load of each file by normalized path, kept in the rest pose and only used to create instances
+	std::unordered_map<std::string, std::shared_ptr<Model>> prototypes_;
+
+	// Requests waiting for a file being loaded by the workers, by normalized path, only touched on the GL thread
+	std::unordered_map<std::string, std::vector<std::pair<std::string, LoadCallback>>> inFlight_;
+
+	// Parsed loads whose textures another load is still uploading, retried once per update instead of spinning in the queue
+	struct WaitingLoad {
+		std::string key;
+		std::string path;
+		std::shared_ptr<Model> prototype;
+	};
+	std::vector<WaitingLoad> waitingLoads_;
+	std::vector<WaitingLoad> retryingLoads_; // Swapped with waitingLoads_ while they are retried
+
+	std::string makeModelName_(std::string const& path, std::string const& name) const;
+	std::shared_ptr<Model> makeInstance_(Model const& prototype, std::string const& path, std::string const& name) const;
+	void finishAsyncLoad_(std::string const& key, std::string const& path, std::shared_ptr<Model> prototype);
 };
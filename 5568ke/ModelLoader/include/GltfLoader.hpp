@@ -1,6 +1,8 @@
 #pragma once
 
 #include <tiny_gltf.h>
+#include <filesystem>
+#include <functional>
 #include <glm/glm.hpp>
 #include <memory>
 #include <string>
@@ -8,7 +10,9 @@
 
 #include "BoundingBox.hpp"
 #include "Material.hpp"
+#include "ModelCache.hpp"
 #include "Texture.hpp"
+#include "TextureCompressor.hpp"
 
 class Model;
 class Node;
@@ -19,22 +23,62 @@ public:
 	GltfLoader() = default;
 	~GltfLoader() = default;
 
-	// Main loading method
+	// Main loading method, GL thread only, the model is ready to draw on return
 	std::shared_ptr<Model> loadModel(std::string const& path);
 
+	// File I/O, parsing, image decoding and vertex conversion on the calling thread, which may be any thread.
+	// The GL uploads (Mesh::setup, glTexImage2D) are pushed to GLUploadQueue, the model can be drawn once ModelAsset::isResident.
+	// A loader holds per-file state, so concurrent parses need one loader each
+	std::shared_ptr<Model> parseModel(std::string const& path);
+
+	// Resample the animation clips into uniform rate pose tracks at load time (see AnimationClip::bake)
+	bool bakeAnimations{true};
+	float bakeSampleRate{60.0f};
+
+	// Read the binary cache next to the file when it is up to date, and write it after parsing the glTF (see ModelCache)
+	// The cache only holds baked tracks, so it is skipped when bakeAnimations is off
+	bool useModelCache{true};
+
+	// Upload 8 bit color textures as BC1/BC3 with a prebuilt mip chain when the driver supports it (see TextureCompressor)
+	bool compressTextures{true};
+
+	// Reorder triangles and vertices for the GPU vertex caches (see MeshOptimizer)
+	bool optimizeMeshes{true};
+	// Append simplified index ranges to every primitive for distant draws (see MeshSimplifier)
+	bool generateLods{true};
+
 private:
+	// What the GL upload of a texture needs, the compressed chain when it is not empty, otherwise the decoded image
+	struct TextureData {
+		tinygltf::Image image;
+		TextureCompressor::CompressedImage compressed;
+	};
+
 	// Main GLTF loading implementation
 	std::shared_ptr<Model> loadGltf_(std::string const& path, MaterialType type = MaterialType::BlinnPhong);
 
+	// Directory of the file being loaded, image URIs are relative to it
+	std::filesystem::path baseDir_;
+	// Handles of the cached textures used by the model being loaded, moved into Model::textures
+	std::vector<std::shared_ptr<Texture>> textures_;
+	// What the binary cache needs to find each of textures_ again
+	std::vector<ModelCache::TextureRecord> textureRecords_;
+
+	std::shared_ptr<Model> loadFromCache_(std::string const& path);
+
 	// Helper methods
 	Texture* loadTexture_(tinygltf::Model const& model, int textureIndex, TextureType type);
+	// Texture from the TextureCache, on a miss a new one is created and loadData is called for its upload
+	Texture* acquireTexture_(std::string const& key, TextureType type, std::string const& uri, std::size_t bytes, std::function<TextureData()> const& loadData);
+	bool shouldCompress_() const { return compressTextures && TextureCompressor::isSupported(); }
+	TextureData prepareTexture_(tinygltf::Image image) const;
 	Material* createMaterial_(tinygltf::Model const& model, tinygltf::Primitive const& primitive, MaterialType type);
 	void processMesh_(tinygltf::Model const& model, tinygltf::Mesh const& mesh, Mesh& outMesh, MaterialType materialType);
 
 	// Animation loading methods
 	void loadAnimations_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel);
 	void loadNodeHierarchy_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel);
-	void processNodeTreeRecursive_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel, int nodeIndex, glm::mat4 const& parentMatrix);
+	void processNodeTreeRecursive_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel, int nodeIndex);
 
 	// Skin and animation data loading
 	void loadSkinData_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read only memory mapping of a whole file, unmapped on destruction.
+ * A file that can't be mapped (missing, empty) leaves isOpen() false.
+ */
+class MappedFile {
+public:
+	MappedFile() = default;
+	explicit MappedFile(std::string const& path) { open(path); }
+	~MappedFile() { close(); }
+
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	bool open(std::string const& path);
+	void close();
+
+	bool isOpen() const { return data_ != nullptr; }
+	unsigned char const* data() const { return static_cast<unsigned char const*>(data_); }
+	std::size_t size() const { return size_; }
+
+private:
+	void const* data_{nullptr};
+	std::size_t size_{0};
+#ifdef _WIN32
+	void* file_{nullptr};
+	void* mapping_{nullptr};
+#endif
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+class Mesh;
+
+/**
+ * @brief Load time level of detail generation with quadric error metrics (Garland & Heckbert).
+ *
+ * Every primitive is simplified by edge collapses, cheapest quadric error first, and a snapshot of its triangles is
+ * appended to the mesh index buffer as a Primitive::Lod each time the triangle count halves. A vertex is always collapsed
+ * onto one of its neighbours, so the levels reuse the original vertices and skinned meshes keep valid bone weights and UVs.
+ * Border vertices and UV / normal seams (several vertices at one position) never move, so the levels keep their outline
+ * and don't tear open.
+ */
+namespace MeshSimplifier {
+
+constexpr int k_maxLods = 3;
+// Each level aims for this fraction of the triangles of the previous one
+constexpr float k_lodRatio = 0.5f;
+// A level reaching less than this reduction is not kept, the simplification ran out of collapses
+constexpr float k_minReduction = 0.8f;
+// Primitives smaller than this are drawn at full detail
+constexpr unsigned int k_minTriangles = 64;
+
+// Append the LOD index ranges of every primitive, run after MeshOptimizer::optimize since it renumbers the vertices
+void generateLods(Mesh& mesh);
+
+} // namespace MeshSimplifier
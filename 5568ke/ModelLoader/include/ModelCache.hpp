@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tiny_gltf.h>
+
+#include "Texture.hpp"
+#include "TextureCompressor.hpp"
+
+class Model;
+
+/**
+ * @brief Binary cache of a parsed glTF model, so later launches skip the JSON parsing and the accessor conversion.
+ *
+ * The cache is written next to the source file (scene.gltf -> scene.gltf.modelcache) after a successful glTF load, and read
+ * through a memory mapping. It holds the meshes in the Vertex layout, the materials, the node tree, the skin data and the
+ * baked animation tracks, every array 16 byte aligned. Compressed textures keep their whole BC mip chain in the cache, so
+ * they are uploaded without decoding the image. Other images are referenced by file and decoded again, embedded images
+ * keep their pixels in the cache.
+ *
+ * The header stores a format version, the Vertex size, the bake rate, whether textures are compressed, whether meshes
+ * were optimized and whether LODs were generated, and a stamp (size, mtime, content hash) of every file the model was
+ * built from. A file whose mtime changed is accepted when its content hash still matches, and its new mtime is written
+ * back so the next launch skips the hash.
+ * Any mismatch makes read return nullptr and the caller loads the glTF again.
+ */
+namespace ModelCache {
+
+constexpr std::uint32_t k_magic = 0x4D43354B; // "K5CM"
+constexpr std::uint32_t k_version = 7;
+
+// A texture of ModelAsset::textures, in the same order
+struct TextureRecord {
+	std::string key; // TextureCache key, the image of a "file:" key is decoded again from that file
+	TextureType type{TextureType::Diffuse};
+	std::string uri;
+	tinygltf::Image image; // Size and format, plus the pixels when the image is embedded and not compressed
+	TextureCompressor::CompressedImage compressed;
+};
+
+std::filesystem::path getCachePath(std::string const& sourcePath);
+
+// 'dependencies' are the files the model was built from: the source and its external buffers and images
+bool write(std::string const& sourcePath, Model const& model, std::vector<TextureRecord> const& textures,
+					 std::vector<std::filesystem::path> const& dependencies, float bakeSampleRate, bool compressedTextures,
+					 bool optimizedMeshes, bool lods);
+
+// nullptr when there is no valid cache. The material textures are resolved by resolveTexture, called once per record in order
+std::shared_ptr<Model> read(std::string const& sourcePath, float bakeSampleRate, bool compressedTextures, bool optimizedMeshes, bool lods,
+													 std::function<Texture*(TextureRecord const&)> const& resolveTexture);
+
+} // namespace ModelCache
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "Texture.hpp"
+
+/**
+ * @brief Textures shared between all loaded models, so an image used by several materials or models is uploaded once.
+ *
+ * Keys are built by the loader from the resolved image file path, or from a hash of the pixels for embedded images.
+ * The cache only holds weak references, the GL texture is deleted when the last model using it releases its handle.
+ * All methods are thread safe, a handle released off the GL thread has its texture deleted through GLUploadQueue.
+ */
+class TextureCache {
+public:
+	static TextureCache& getInstance()
+	{
+		static TextureCache instance;
+		return instance;
+	}
+
+	// Live texture stored under key, nullptr on a miss
+	std::shared_ptr<Texture> find(std::string const& key);
+	// Take ownership of an uploaded texture, 'bytes' is its estimated GPU size
+	std::shared_ptr<Texture> insert(std::string const& key, Texture* texture, std::size_t bytes);
+	// find, or on a miss insert what 'create' returns, in one step so concurrent loaders never create the same texture twice
+	// 'create' runs under the cache lock and returns the texture with its estimated GPU size
+	std::shared_ptr<Texture> findOrInsert(std::string const& key, std::function<std::pair<Texture*, std::size_t>()> const& create);
+
+	struct Stats {
+		std::size_t residentTextures{};
+		std::size_t residentBytes{};
+		std::size_t hits{};		// Lookups served without an upload
+		std::size_t uploads{};
+	};
+	Stats getStats();
+
+	// Forget every entry at shutdown, once the models holding the handles are gone and while the GL context is current
+	void clear();
+
+private:
+	TextureCache() = default;
+
+	std::shared_ptr<Texture> find_(std::string const& key);
+	std::shared_ptr<Texture> insert_(std::string const& key, Texture* texture, std::size_t bytes);
+
+	struct Entry {
+		std::weak_ptr<Texture> texture;
+		std::size_t bytes{};
+	};
+	std::unordered_map<std::string, Entry> entries_;
+	std::mutex mutex_;
+	std::size_t hits_{};
+	std::size_t uploads_{};
+};
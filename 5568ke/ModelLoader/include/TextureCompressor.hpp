@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <tiny_gltf.h>
+
+#include "include_5568ke.hpp"
+
+/**
+ * @brief Block compression of decoded textures, with the whole mip chain built on the CPU.
+ *
+ * Opaque images become BC1 (8 bytes per 4x4 block) and images with alpha BC3 (16 bytes per block), through stb_dxt.
+ * The levels are box filtered from the RGBA8 image, so a compressed texture is uploaded with glCompressedTexImage2D
+ * per level and needs no glGenerateMipmap. Only 8 bit RGB/RGBA images are compressed, and only when the driver
+ * exposes S3TC (detectSupport, called on the GL thread once the context exists).
+ */
+namespace TextureCompressor {
+
+enum class Format : std::uint32_t { None, BC1, BC3 };
+
+struct MipLevel {
+	std::int32_t width;
+	std::int32_t height;
+	std::uint64_t offset; // Into CompressedImage::data
+	std::uint64_t size;
+};
+
+struct CompressedImage {
+	Format format{Format::None};
+	std::vector<MipLevel> levels;
+	std::vector<unsigned char> data;
+
+	bool empty() const { return format == Format::None || levels.empty(); }
+};
+
+// Query the compressed formats of the current context, GL thread only
+void detectSupport();
+bool isSupported();
+
+bool canCompress(tinygltf::Image const& image);
+// Upper bound of the compressed size of an image with its mip chain
+std::size_t estimateBytes(tinygltf::Image const& image);
+
+// Empty result when the image can't be compressed
+CompressedImage compress(tinygltf::Image const& image);
+
+GLenum getGLFormat(Format format);
+
+} // namespace TextureCompressor
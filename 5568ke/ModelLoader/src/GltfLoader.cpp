@@ -2,25 +2,177 @@
 
 #include "GltfLoader.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <string_view>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 
 #include "AnimationClip.hpp"
 #include "BlinnPhongMaterial.hpp"
+#include "GLUploadQueue.hpp"
+#include "MappedFile.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
 #include "Mesh.hpp"
 #include "Model.hpp"
 #include "Node.hpp"
 #include "Primitive.hpp"
+#include "TextureCache.hpp"
+#include "TextureCompressor.hpp"
 #include "Vertex.hpp"
 
-std::shared_ptr<Model> GltfLoader::loadModel(std::string const& path) { return loadGltf_(path, MaterialType::BlinnPhong); }
+namespace {
+constexpr std::string_view k_fileKeyPrefix = "file:";
+
+// Whether a buffer or image URI names a file next to the glTF, rather than embedded data
+bool isExternalUri(std::string const& uri) { return !uri.empty() && uri.rfind("data:", 0) != 0; }
+
+// Cache key of an image, the resolved file path when it has one, otherwise a hash of the decoded pixels (.glb and data URIs)
+std::string makeTextureKey(std::filesystem::path const& baseDir, tinygltf::Image const& image)
+{
+	if (isExternalUri(image.uri))
+		return std::string(k_fileKeyPrefix) + (baseDir / image.uri).lexically_normal().generic_string();
+
+	// FNV-1a
+	std::uint64_t hash = 14695981039346656037ull;
+	for (unsigned char byte : image.image) {
+		hash ^= byte;
+		hash *= 1099511628211ull;
+	}
+	return "pixels:" + std::to_string(hash) + ':' + std::to_string(image.width) + 'x' + std::to_string(image.height) + 'x' + std::to_string(image.component) +
+				 'x' + std::to_string(image.pixel_type);
+}
+
+// Bytes per channel of a decoded image
+std::size_t getComponentBytes(int pixelType)
+{
+	if (pixelType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+		return 2;
+	if (pixelType == TINYGLTF_COMPONENT_TYPE_FLOAT)
+		return 4;
+	return 1;
+}
+
+// Base level plus about a third for the mip chain
+std::size_t estimateTextureBytes(tinygltf::Image const& image)
+{
+	std::size_t levelBytes = static_cast<std::size_t>(std::max(image.width, 0)) * std::max(image.height, 0) * std::max(image.component, 1) * getComponentBytes(image.pixel_type);
+	return levelBytes + levelBytes / 3;
+}
+
+// Decode an image file the way tinygltf does, an empty image when it fails
+tinygltf::Image loadImageFile(std::string const& path)
+{
+	tinygltf::Image image;
+	MappedFile file(path);
+	std::string err, warn;
+	if (!file.isOpen() || !tinygltf::LoadImageData(&image, 0, &err, &warn, 0, 0, file.data(), static_cast<int>(file.size()), nullptr))
+		image.image.clear();
+	return image;
+}
+
+// Queue the VAO setup of every mesh, the asset is kept alive by the jobs
+void queueMeshUploads(std::shared_ptr<ModelAsset> const& asset)
+{
+	for (std::size_t i = 0; i < asset->meshes.size(); ++i)
+		GLUploadQueue::getInstance().push([asset, i] { asset->meshes[i].setup(); });
+}
+
+// Create the GL texture of a block compressed mip chain, GL thread only
+void uploadCompressedTexture(Texture& texture, TextureCompressor::CompressedImage const& compressed)
+{
+	glGenTextures(1, &texture.id);
+	glBindTexture(GL_TEXTURE_2D, texture.id);
+
+	// Every level comes from the cache or the loader, nothing is generated here
+	GLenum format = TextureCompressor::getGLFormat(compressed.format);
+	for (std::size_t i = 0; i < compressed.levels.size(); ++i) {
+		auto const& level = compressed.levels[i];
+		glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), format, level.width, level.height, 0, static_cast<GLsizei>(level.size),
+													 compressed.data.data() + level.offset);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(compressed.levels.size()) - 1);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Create the GL texture of a decoded image, GL thread only
+void uploadTexture(Texture& texture, tinygltf::Image const& image, TextureCompressor::CompressedImage const& compressed)
+{
+	if (!compressed.empty()) {
+		uploadCompressedTexture(texture, compressed);
+		return;
+	}
+
+	glGenTextures(1, &texture.id);
+	glBindTexture(GL_TEXTURE_2D, texture.id);
+
+	GLenum format, internalFormat;
+	if (image.component == 1) {
+		format = GL_RED;
+		internalFormat = GL_RED;
+	}
+	else if (image.component == 3) {
+		format = GL_RGB;
+		internalFormat = GL_RGB;
+	}
+	else {
+		format = GL_RGBA;
+		internalFormat = GL_RGBA;
+	}
+
+	// Make sure the pixel type is correct
+	GLenum pixelType = GL_UNSIGNED_BYTE;
+	if (image.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+		pixelType = GL_UNSIGNED_SHORT;
+	else if (image.pixel_type == TINYGLTF_COMPONENT_TYPE_FLOAT)
+		pixelType = GL_FLOAT;
+
+	// std::cout << "[GltfLoader INFO] Loading texture: " << image.uri << " (" << image.width << "x" << image.height << ", components: " << image.component << ")"
+	// << std::endl;
+
+	// An image that failed to decode leaves an empty texture, so the model still finishes loading
+	if (!image.image.empty()) {
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, pixelType, image.image.data());
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+} // namespace
+
+std::shared_ptr<Model> GltfLoader::loadModel(std::string const& path)
+{
+	std::shared_ptr<Model> model = parseModel(path);
+	GLUploadQueue::getInstance().drainAll();
+	return model;
+}
+
+std::shared_ptr<Model> GltfLoader::parseModel(std::string const& path) { return loadGltf_(path, MaterialType::BlinnPhong); }
 
 std::shared_ptr<Model> GltfLoader::loadGltf_(std::string const& path, MaterialType type)
 {
+	bool useCache = useModelCache && bakeAnimations;
+	if (useCache) {
+		if (std::shared_ptr<Model> cached = loadFromCache_(path))
+			return cached;
+	}
+
 	tinygltf::Model gltfModel;
 	tinygltf::TinyGLTF loader;
 	std::string err, warn;
@@ -52,7 +204,12 @@ std::shared_ptr<Model> GltfLoader::loadGltf_(std::string const& path, MaterialTy
 
 	// Create and populate model
 	std::shared_ptr<Model> model = std::make_shared<Model>();
-	model->meshNodeIndices.resize(gltfModel.meshes.size(), -1);
+	model->asset = std::make_shared<ModelAsset>();
+	model->asset->sourcePath = path;
+	baseDir_ = std::filesystem::path(path).parent_path();
+	textures_.clear();
+	textureRecords_.clear();
+	model->asset->meshNodeIndices.resize(gltfModel.meshes.size(), -1);
 
 	// std::cout << "[GltfLoader INFO] GLTF file has:\n"
 	// << gltfModel.accessors.size() << " accessors\n"
@@ -77,57 +234,113 @@ std::shared_ptr<Model> GltfLoader::loadGltf_(std::string const& path, MaterialTy
 		Mesh outMesh;
 		processMesh_(gltfModel, mesh, outMesh, type);
 
-		// Setup OpenGL buffers and VAO
-		outMesh.setup();
+		if (optimizeMeshes) {
+			MeshOptimizer::optimize(outMesh);
+			// std::cout << "[GltfLoader INFO] Mesh " << mesh.name << " ACMR " << outMesh.acmrSource << " -> " << outMesh.acmr << std::endl;
+		}
+		else {
+			outMesh.acmrSource = outMesh.acmr = MeshOptimizer::computeACMR(outMesh);
+		}
+		if (generateLods)
+			MeshSimplifier::generateLods(outMesh);
 
 		// Calculate bounding box
 		BoundingBox bbox = BBoxUtil::getMeshBBox(outMesh);
-		model->boundingBoxes.push_back(bbox);
+		model->asset->boundingBoxes.push_back(bbox);
 
 		// Add mesh to model
-		model->meshes.push_back(std::move(outMesh));
+		model->asset->meshes.push_back(std::move(outMesh));
 	}
 
 	// Map each mesh to its node
 	for (size_t i = 0; i < gltfModel.nodes.size(); i++) {
 		auto const& node = gltfModel.nodes[i];
-		if (node.mesh >= 0 && static_cast<std::size_t>(node.mesh) < model->meshNodeIndices.size()) {
-			model->meshNodeIndices[node.mesh] = i;
+		if (node.mesh >= 0 && static_cast<std::size_t>(node.mesh) < model->asset->meshNodeIndices.size()) {
+			model->asset->meshNodeIndices[node.mesh] = i;
 			// std::cout << "[GltfLoader] Node " << i << " references mesh " << node.mesh << std::endl;
 		}
 	}
 
-	// Load node hierarchy and skin data if available
-	loadNodeHierarchy_(model, gltfModel);
+	// The model holds the texture handles its materials point to
+	model->asset->textures = std::move(textures_);
+	textures_.clear();
 
+	// Skin data rewrites the bone ids, so it is loaded before the upload jobs read the vertices
 	if (!gltfModel.skins.empty()) {
 		// std::cout << "[GltfLoader INFO] Find skin data, starting to load skin data." << std::endl;
 		loadSkinData_(model, gltfModel);
 	}
 
+	// Setup OpenGL buffers and VAO on the GL thread
+	queueMeshUploads(model->asset);
+
+	// Load node hierarchy
+	loadNodeHierarchy_(model, gltfModel);
+
 	// Load animations if available
 	if (!gltfModel.animations.empty()) {
 		loadAnimations_(model, gltfModel);
-		model->updateLocalMatrices();
-		// std::cout << "[GltfLoader INFO] Loaded " << model->animations.size() << " animation clips" << std::endl;
+		// std::cout << "[GltfLoader INFO] Loaded " << model->asset->animations.size() << " animation clips" << std::endl;
 	}
 
-	if (model->rootNode) {
-		// Calculate all node matrices starting from the root
-		NodeUtil::updateNodeTreeMatricesRecursive(model->rootNode, glm::mat4(1.0f));
-		// std::cout << "[GltfLoader] Node matrices calculated for static transforms" << std::endl;
-	}
-
-	// Calculate global bounding box and store on the model
-	if (!model->boundingBoxes.empty()) {
-		BBoxUtil::updateLocalBBox(*model);
+	// Calculate all node matrices, joint matrices and the global bounding box in one pass over the pose pipeline
+	model->updatePose();
 
+	if (!model->asset->boundingBoxes.empty()) {
 		// Print global bounding box info
 		// std::cout << "[GltfLoader INFO] Model global bounding box: min(" << model->localSpaceBBox.min.x << ", " << model->localSpaceBBox.min.y << ", "
 		// << model->localSpaceBBox.min.z << "), max(" << model->localSpaceBBox.max.x << ", " << model->localSpaceBBox.max.y << ", " << model->localSpaceBBox.max.z
 		// << ")" << std::endl;
 	}
 
+	// Write the binary cache for the next launch, from the files the model was built from
+	if (useCache) {
+		std::vector<std::filesystem::path> dependencies{path};
+		for (tinygltf::Buffer const& buffer : gltfModel.buffers)
+			if (isExternalUri(buffer.uri))
+				dependencies.push_back(baseDir_ / buffer.uri);
+		for (tinygltf::Image const& image : gltfModel.images)
+			if (isExternalUri(image.uri))
+				dependencies.push_back(baseDir_ / image.uri);
+
+		if (!ModelCache::write(path, *model, textureRecords_, dependencies, bakeSampleRate, shouldCompress_(), optimizeMeshes, generateLods)) {
+			// std::cout << "[GltfLoader INFO] Failed to write the model cache of " << path << std::endl;
+		}
+	}
+	textureRecords_.clear();
+
+	return model;
+}
+
+std::shared_ptr<Model> GltfLoader::loadFromCache_(std::string const& path)
+{
+	baseDir_ = std::filesystem::path(path).parent_path();
+	textures_.clear();
+
+	std::shared_ptr<Model> model = ModelCache::read(path, bakeSampleRate, shouldCompress_(), optimizeMeshes, generateLods, [this](ModelCache::TextureRecord const& record) {
+		std::size_t bytes = record.compressed.empty() ? estimateTextureBytes(record.image) : record.compressed.data.size();
+		return acquireTexture_(record.key, record.type, record.uri, bytes, [this, &record] {
+			// Compressed chains are uploaded as they are, embedded images come with their pixels, file images are decoded again
+			if (!record.compressed.empty())
+				return TextureData{{}, record.compressed};
+			if (!record.image.image.empty())
+				return prepareTexture_(record.image);
+			return prepareTexture_(loadImageFile(record.key.substr(k_fileKeyPrefix.size())));
+		});
+	});
+
+	if (!model) {
+		textures_.clear();
+		return nullptr;
+	}
+
+	model->asset->textures = std::move(textures_);
+	textures_.clear();
+
+	queueMeshUploads(model->asset);
+	model->updatePose();
+
+	// std::cout << "[GltfLoader INFO] Loaded " << path << " from its model cache" << std::endl;
 	return model;
 }
 
@@ -136,60 +349,77 @@ Texture* GltfLoader::loadTexture_(tinygltf::Model const& model, int textureIndex
 	if (textureIndex < 0 || static_cast<std::size_t>(textureIndex) >= model.textures.size())
 		return nullptr;
 
-	auto* texture = new Texture();
-	texture->type = type;
-
 	tinygltf::Texture const& gltfTexture = model.textures[textureIndex];
-	if (gltfTexture.source < 0 || static_cast<std::size_t>(gltfTexture.source) >= model.images.size()) {
-		delete texture;
+	if (gltfTexture.source < 0 || static_cast<std::size_t>(gltfTexture.source) >= model.images.size())
 		return nullptr;
-	}
 
 	tinygltf::Image const& image = model.images[gltfTexture.source];
 
-	// Save the path for debugging/reference
-	texture->path = image.uri;
-
-	glGenTextures(1, &texture->id);
-	glBindTexture(GL_TEXTURE_2D, texture->id);
-
-	GLenum format, internalFormat;
-	if (image.component == 1) {
-		format = GL_RED;
-		internalFormat = GL_RED;
-	}
-	else if (image.component == 3) {
-		format = GL_RGB;
-		internalFormat = GL_RGB;
-	}
-	else {
-		format = GL_RGBA;
-		internalFormat = GL_RGBA;
+	// Reuse the texture when this image was already loaded, by this model or another one
+	// The image is copied for the upload since the glTF model is gone by the time it runs on the GL thread
+	std::string key = makeTextureKey(baseDir_, image);
+	bool compress = shouldCompress_() && TextureCompressor::canCompress(image);
+	std::size_t bytes = compress ? TextureCompressor::estimateBytes(image) : estimateTextureBytes(image);
+
+	TextureCompressor::CompressedImage compressed;
+	std::size_t textureCount = textures_.size();
+	Texture* texture = acquireTexture_(key, type, image.uri, bytes, [&] {
+		if (!compress)
+			return TextureData{image, {}};
+
+		// Kept for the model cache as well
+		compressed = TextureCompressor::compress(image);
+		return TextureData{{}, compressed};
+	});
+
+	// Record new textures for the model cache, compressed ones keep their mip chain, other embedded images their pixels
+	if (useModelCache && textures_.size() != textureCount) {
+		ModelCache::TextureRecord& record = textureRecords_.emplace_back();
+		record.key = key;
+		record.type = type;
+		record.uri = image.uri;
+		record.image.width = image.width;
+		record.image.height = image.height;
+		record.image.component = image.component;
+		record.image.bits = image.bits;
+		record.image.pixel_type = image.pixel_type;
+		record.compressed = std::move(compressed);
+		if (key.rfind(k_fileKeyPrefix, 0) != 0 && record.compressed.empty())
+			record.image.image = image.image;
 	}
 
-	// Make sure the pixel type is correct
-	GLenum pixelType = GL_UNSIGNED_BYTE;
-	if (image.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-		pixelType = GL_UNSIGNED_SHORT;
-	}
-	else if (image.pixel_type == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-		pixelType = GL_FLOAT;
-	}
+	return texture;
+}
 
-	// std::cout << "[GltfLoader INFO] Loading texture: " << image.uri << " (" << image.width << "x" << image.height << ", components: " << image.component << ")"
-	// << std::endl;
+Texture* GltfLoader::acquireTexture_(std::string const& key, TextureType type, std::string const& uri, std::size_t bytes,
+																		 std::function<TextureData()> const& loadData)
+{
+	Texture* created = nullptr;
+	std::shared_ptr<Texture> handle = TextureCache::getInstance().findOrInsert(key, [&] {
+		created = new Texture();
+		created->type = type;
 
-	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, pixelType, image.image.data());
-	glGenerateMipmap(GL_TEXTURE_2D);
+		// Save the path for debugging/reference
+		created->path = uri;
+		return std::pair<Texture*, std::size_t>{created, bytes};
+	});
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	// The data is only loaded on a miss, outside the cache lock, and uploaded on the GL thread
+	if (created)
+		GLUploadQueue::getInstance().push([handle, data = loadData()] { uploadTexture(*handle, data.image, data.compressed); });
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	// Keep one handle per texture used by the model
+	if (std::find(textures_.begin(), textures_.end(), handle) == textures_.end())
+		textures_.push_back(handle);
 
-	return texture;
+	return handle.get();
+}
+
+GltfLoader::TextureData GltfLoader::prepareTexture_(tinygltf::Image image) const
+{
+	if (!shouldCompress_() || !TextureCompressor::canCompress(image))
+		return TextureData{std::move(image), {}};
+	return TextureData{{}, TextureCompressor::compress(image)};
 }
 
 Material* GltfLoader::createMaterial_(tinygltf::Model const& model, tinygltf::Primitive const& primitive, MaterialType type)
@@ -427,7 +657,7 @@ void GltfLoader::loadAnimations_(std::shared_ptr<Model> model, tinygltf::Model c
 	// std::cout << "[GltfLoader INFO] Starting to load animations. Count: " << gltfModel.animations.size() << std::endl;
 
 	// Clear any existing animations
-	model->animations.clear();
+	model->asset->animations.clear();
 
 	for (size_t animIndex = 0; animIndex < gltfModel.animations.size(); animIndex++) {
 		tinygltf::Animation const& anim = gltfModel.animations[animIndex];
@@ -471,14 +701,16 @@ void GltfLoader::loadAnimations_(std::shared_ptr<Model> model, tinygltf::Model c
 		// Only add the clip if it has valid channels
 		if (clip->getDuration() > 0) {
 			// std::cout << "[GltfLoader INFO] Animation '" << clipName << "' has duration: " << clip->getDuration() << std::endl;
-			model->animations.push_back(clip);
+			if (bakeAnimations)
+				clip->bake(model->nodes, bakeSampleRate);
+			model->asset->animations.push_back(clip);
 		}
 		else {
 			// std::cout << "[GltfLoader INFO] Skipping animation '" << clipName << "' with zero duration" << std::endl;
 		}
 	}
 
-	// std::cout << "[GltfLoader INFO] Finished loading all animations. Total: " << model->animations.size() << std::endl;
+	// std::cout << "[GltfLoader INFO] Finished loading all animations. Total: " << model->asset->animations.size() << std::endl;
 }
 
 void GltfLoader::loadNodeHierarchy_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel)
@@ -517,7 +749,8 @@ void GltfLoader::loadNodeHierarchy_(std::shared_ptr<Model> model, tinygltf::Mode
 
 		// Process the entire node hierarchy starting from the root
 		// std::cout << "[GltfLoader INFO] Processing node hierarchy starting from root" << std::endl;
-		processNodeTreeRecursive_(model, gltfModel, rootNodeIndex, glm::mat4(1.0f));
+		processNodeTreeRecursive_(model, gltfModel, rootNodeIndex);
+		NodeUtil::buildNodeHierarchy(*model);
 
 		// std::cout << "[GltfLoader INFO] Node hierarchy loaded successfully" << std::endl;
 	} catch (std::exception const& e) {
@@ -527,7 +760,7 @@ void GltfLoader::loadNodeHierarchy_(std::shared_ptr<Model> model, tinygltf::Mode
 	}
 }
 
-void GltfLoader::processNodeTreeRecursive_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel, int nodeIndex, glm::mat4 const& parentMatrix)
+void GltfLoader::processNodeTreeRecursive_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel, int nodeIndex)
 {
 	// std::cout << "[GltfLoader INFO] Processing node " << nodeIndex << std::endl;
 
@@ -617,10 +850,6 @@ void GltfLoader::processNodeTreeRecursive_(std::shared_ptr<Model> model, tinyglt
 	}
 
 	try {
-		// Calculate matrices
-		currentNode->updateLocalTRSMatrix();
-		currentNode->updateNodeMatrix(parentMatrix);
-
 		// Process child nodes
 		// std::cout << "[GltfLoader INFO] Node " << nodeIndex << " has " << node.children.size() << " children" << std::endl;
 		for (size_t i = 0; i < node.children.size(); i++) {
@@ -653,7 +882,7 @@ void GltfLoader::processNodeTreeRecursive_(std::shared_ptr<Model> model, tinyglt
 			currentNode->children.push_back(childNode);
 
 			// Recursively process child node
-			processNodeTreeRecursive_(model, gltfModel, childIndex, currentNode->getNodeMatrix());
+			processNodeTreeRecursive_(model, gltfModel, childIndex);
 		}
 	} catch (std::exception const& e) {
 		// std::cout << "[GltfLoader ERROR] Exception while processing node " << nodeIndex << ": " << e.what() << std::endl;
@@ -664,91 +893,55 @@ void GltfLoader::processNodeTreeRecursive_(std::shared_ptr<Model> model, tinyglt
 
 void GltfLoader::loadSkinData_(std::shared_ptr<Model> model, tinygltf::Model const& gltfModel)
 {
-	// Process only the first skin for simplicity
-	tinygltf::Skin const& skin = gltfModel.skins[0];
-
-	// Load inverse bind matrices
-	// Note: skinnedPosition = jointMatrix * inverseBindMatrix * vertexPosition;
-	if (skin.inverseBindMatrices >= 0) {
-		tinygltf::Accessor const& accessor = gltfModel.accessors[skin.inverseBindMatrices];
-		tinygltf::BufferView const& bufferView = gltfModel.bufferViews[accessor.bufferView];
-		tinygltf::Buffer const& buffer = gltfModel.buffers[bufferView.buffer];
-
-		size_t numMatrices = accessor.count;
-		model->inverseBindMatrices.resize(numMatrices);
-
-		float const* data = reinterpret_cast<float const*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
-		for (size_t i = 0; i < numMatrices; i++) {
-			model->inverseBindMatrices[i] = glm::make_mat4(data + i * 16);
-		}
+	ModelAsset& asset = *model->asset;
+
+	// Every skin gets a range of the joint palette, so one upload covers all the skins of the model
+	for (tinygltf::Skin const& skin : gltfModel.skins) {
+		std::size_t firstJoint = asset.jointNodes.size();
+		asset.skinJointOffsets.push_back(static_cast<int>(firstJoint));
+		asset.jointNodes.insert(asset.jointNodes.end(), skin.joints.begin(), skin.joints.end());
+		asset.inverseBindMatrices.resize(asset.jointNodes.size(), glm::mat4(1.0f));
+
+		// Load inverse bind matrices, identity when the skin has none
+		// Note: skinnedPosition = jointMatrix * inverseBindMatrix * vertexPosition;
+		if (skin.inverseBindMatrices >= 0) {
+			tinygltf::Accessor const& accessor = gltfModel.accessors[skin.inverseBindMatrices];
+			tinygltf::BufferView const& bufferView = gltfModel.bufferViews[accessor.bufferView];
+			tinygltf::Buffer const& buffer = gltfModel.buffers[bufferView.buffer];
+
+			size_t numMatrices = std::min(accessor.count, skin.joints.size());
+			float const* data = reinterpret_cast<float const*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]);
+			for (size_t i = 0; i < numMatrices; i++) {
+				asset.inverseBindMatrices[firstJoint + i] = glm::make_mat4(data + i * 16);
+			}
 
-		// std::cout << "[GltfLoader INFO] Loaded " << numMatrices << " inverse bind matrices" << std::endl;
+			// std::cout << "[GltfLoader INFO] Loaded " << numMatrices << " inverse bind matrices" << std::endl;
+		}
 	}
 
-	// Create joint mapping
-	model->nodeToJointMapping.resize(gltfModel.nodes.size(), -1);
-	for (size_t i = 0; i < skin.joints.size(); i++) {
-		int nodeIndex = skin.joints[i];
-		model->nodeToJointMapping[nodeIndex] = static_cast<int>(i);
+	// Bone ids index the joints of their skin, move them to the palette range of the skin of the node drawing the mesh
+	for (std::size_t i = 0; i < asset.meshes.size() && i < asset.meshNodeIndices.size(); ++i) {
+		int nodeIndex = asset.meshNodeIndices[i];
+		if (nodeIndex < 0 || static_cast<std::size_t>(nodeIndex) >= gltfModel.nodes.size())
+			continue;
+		int skinIndex = gltfModel.nodes[nodeIndex].skin;
+		if (skinIndex < 0 || static_cast<std::size_t>(skinIndex) >= asset.skinJointOffsets.size())
+			continue;
+
+		int offset = asset.skinJointOffsets[skinIndex];
+		for (Vertex& v : asset.meshes[i].vertices) {
+			for (int j = 0; j < 4; j++) {
+				if (v.boneWeights[j] > 0.0f)
+					v.boneIds[j] += offset;
+			}
+		}
 	}
 
 	// Initialize joint matrices with identity matrices
-	model->jointMatrices.resize(skin.joints.size(), glm::mat4(1.0f));
-
-	// Load vertex joint and weight data
-	if (!gltfModel.meshes.empty() && !gltfModel.meshes[0].primitives.empty()) {
-		tinygltf::Primitive const& primitive = gltfModel.meshes[0].primitives[0];
+	model->jointMatrices.assign(asset.jointNodes.size(), glm::mat4(1.0f));
 
-		auto jointsIt = primitive.attributes.find("JOINTS_0");	 // which bones this vertex is bound to (index)
-		auto weightsIt = primitive.attributes.find("WEIGHTS_0"); // the influence (weight) of the corresponding bones
+	// Per-joint bind pose bounds, used to update the animated bounding box without skinning every vertex
+	BBoxUtil::computeJointBindBBoxes(*model);
 
-		if (jointsIt != primitive.attributes.end() && weightsIt != primitive.attributes.end()) {
-			int jointsAccessorIndex = jointsIt->second;
-			int weightsAccessorIndex = weightsIt->second;
-
-			tinygltf::Accessor const& jointsAccessor = gltfModel.accessors[jointsAccessorIndex];
-			tinygltf::BufferView const& jointsBufferView = gltfModel.bufferViews[jointsAccessor.bufferView];
-			tinygltf::Buffer const& jointsBuffer = gltfModel.buffers[jointsBufferView.buffer];
-
-			tinygltf::Accessor const& weightsAccessor = gltfModel.accessors[weightsAccessorIndex];
-			tinygltf::BufferView const& weightsBufferView = gltfModel.bufferViews[weightsAccessor.bufferView];
-			tinygltf::Buffer const& weightsBuffer = gltfModel.buffers[weightsBufferView.buffer];
-
-			size_t vertexCount = jointsAccessor.count;
-			model->vertexJoints.resize(vertexCount);
-
-			if (jointsAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-				uint16_t const* jointData = reinterpret_cast<uint16_t const*>(&jointsBuffer.data[jointsBufferView.byteOffset + jointsAccessor.byteOffset]);
-				float const* weightData = reinterpret_cast<float const*>(&weightsBuffer.data[weightsBufferView.byteOffset + weightsAccessor.byteOffset]);
-
-				for (size_t i = 0; i < vertexCount; i++) {
-					for (int j = 0; j < 4; j++) {
-						int jointIndex = jointData[i * 4 + j];
-						float weight = weightData[i * 4 + j];
-
-						if (weight > 0.0f) {
-							model->vertexJoints[i].push_back(std::make_pair(jointIndex, weight));
-						}
-					}
-				}
-			}
-			else if (jointsAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-				uint8_t const* jointData = reinterpret_cast<uint8_t const*>(&jointsBuffer.data[jointsBufferView.byteOffset + jointsAccessor.byteOffset]);
-				float const* weightData = reinterpret_cast<float const*>(&weightsBuffer.data[weightsBufferView.byteOffset + weightsAccessor.byteOffset]);
-
-				for (size_t i = 0; i < vertexCount; i++) {
-					for (int j = 0; j < 4; j++) {
-						int jointIndex = jointData[i * 4 + j];
-						float weight = weightData[i * 4 + j];
-
-						if (weight > 0.0f) {
-							model->vertexJoints[i].push_back(std::make_pair(jointIndex, weight));
-						}
-					}
-				}
-			}
-
-			// std::cout << "[GltfLoader INFO] Loaded joint weights for " << vertexCount << " vertices" << std::endl;
-		}
-	}
+	// std::cout << "[GltfLoader INFO] Loaded " << gltfModel.skins.size() << " skins, " << asset.jointNodes.size() << " joints" << std::endl;
 }
@@ -0,0 +1,223 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "Mesh.hpp"
+#include "Vertex.hpp"
+
+namespace {
+// Scoring constants from Forsyth's article
+constexpr float k_cacheDecayPower = 1.5f;
+constexpr float k_lastTriangleScore = 0.75f;
+constexpr float k_valenceBoostScale = 2.0f;
+constexpr float k_valenceBoostPower = 0.5f;
+
+constexpr unsigned int k_unused = std::numeric_limits<unsigned int>::max();
+
+// Vertices near the front of the cache score high, and so do vertices with few triangles left, so lone triangles are not left behind
+float getVertexScore(int cachePosition, int activeTriangles)
+{
+	if (activeTriangles == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+	if (cachePosition >= 0) {
+		// The three vertices of the last triangle get a fixed score, whichever triangle comes next reuses them anyway
+		if (cachePosition < 3)
+			score = k_lastTriangleScore;
+		else
+			score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (MeshOptimizer::k_cacheSize - 3), k_cacheDecayPower);
+	}
+	return score + k_valenceBoostScale * std::pow(static_cast<float>(activeTriangles), -k_valenceBoostPower);
+}
+
+std::size_t countCacheMisses(unsigned int const* indices, std::size_t count, int cacheSize)
+{
+	std::vector<unsigned int> fifo(std::max(cacheSize, 1), k_unused);
+	std::size_t next = 0;
+	std::size_t misses = 0;
+	for (std::size_t i = 0; i < count; ++i) {
+		if (std::find(fifo.begin(), fifo.end(), indices[i]) != fifo.end())
+			continue;
+		fifo[next] = indices[i];
+		next = (next + 1) % fifo.size();
+		++misses;
+	}
+	return misses;
+}
+
+// Forsyth reordering of the triangles of one primitive, whose vertices are [firstVertex, firstVertex + vertexCount)
+void reorderTriangles(unsigned int* indices, std::size_t indexCount, unsigned int firstVertex, std::size_t vertexCount)
+{
+	std::size_t triangleCount = indexCount / 3;
+	auto local = [&](std::size_t i) { return indices[i] - firstVertex; };
+
+	// Triangles of every vertex, the first activeTriangles of each list are the ones not emitted yet
+	std::vector<int> activeTriangles(vertexCount, 0);
+	for (std::size_t i = 0; i < indexCount; ++i)
+		activeTriangles[local(i)]++;
+
+	std::vector<std::size_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (std::size_t v = 0; v < vertexCount; ++v)
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + activeTriangles[v];
+
+	std::vector<std::uint32_t> adjacency(indexCount);
+	std::vector<std::size_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (std::size_t i = 0; i < indexCount; ++i)
+		adjacency[fill[local(i)]++] = static_cast<std::uint32_t>(i / 3);
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (std::size_t v = 0; v < vertexCount; ++v)
+		vertexScores[v] = getVertexScore(-1, activeTriangles[v]);
+
+	auto getTriangleScore = [&](std::size_t t) { return vertexScores[local(t * 3)] + vertexScores[local(t * 3 + 1)] + vertexScores[local(t * 3 + 2)]; };
+
+	std::vector<char> emitted(triangleCount, 0);
+	std::size_t bestTriangle = 0;
+	for (std::size_t t = 1; t < triangleCount; ++t) {
+		if (getTriangleScore(t) > getTriangleScore(bestTriangle))
+			bestTriangle = t;
+	}
+
+	std::vector<unsigned int> output;
+	output.reserve(indexCount);
+	std::vector<unsigned int> cache, newCache;
+	cache.reserve(MeshOptimizer::k_cacheSize + 3);
+	newCache.reserve(MeshOptimizer::k_cacheSize + 3);
+	std::size_t scanCursor = 0;
+
+	for (std::size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+		// Nothing in the cache has triangles left, continue with the next triangle in the original order
+		if (bestTriangle == triangleCount) {
+			while (emitted[scanCursor])
+				++scanCursor;
+			bestTriangle = scanCursor;
+		}
+
+		std::size_t t = bestTriangle;
+		emitted[t] = 1;
+
+		newCache.clear();
+		for (int k = 0; k < 3; ++k) {
+			unsigned int v = local(t * 3 + k);
+			output.push_back(indices[t * 3 + k]);
+			newCache.push_back(v);
+
+			// Swap the triangle out of the active part of the list
+			std::uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+			std::uint32_t* end = begin + activeTriangles[v];
+			std::uint32_t* it = std::find(begin, end, static_cast<std::uint32_t>(t));
+			if (it != end) {
+				std::swap(*it, *(end - 1));
+				activeTriangles[v]--;
+			}
+		}
+
+		// The triangle vertices go to the front, the rest keeps its order, whatever falls past the end is evicted
+		for (unsigned int v : cache) {
+			if (std::find(newCache.begin(), newCache.begin() + 3, v) == newCache.begin() + 3)
+				newCache.push_back(v);
+		}
+		for (std::size_t i = 0; i < newCache.size(); ++i) {
+			unsigned int v = newCache[i];
+			cachePositions[v] = i < static_cast<std::size_t>(MeshOptimizer::k_cacheSize) ? static_cast<int>(i) : -1;
+			vertexScores[v] = getVertexScore(cachePositions[v], activeTriangles[v]);
+		}
+
+		// Only the triangles touching the cache changed score, the next one is picked among them
+		bestTriangle = triangleCount;
+		float bestScore = -1.0f;
+		for (unsigned int v : newCache) {
+			for (int j = 0; j < activeTriangles[v]; ++j) {
+				std::uint32_t other = adjacency[adjacencyOffsets[v] + j];
+				float score = getTriangleScore(other);
+				if (score > bestScore) {
+					bestScore = score;
+					bestTriangle = other;
+				}
+			}
+		}
+
+		if (newCache.size() > static_cast<std::size_t>(MeshOptimizer::k_cacheSize))
+			newCache.resize(MeshOptimizer::k_cacheSize);
+		std::swap(cache, newCache);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+} // namespace
+
+namespace MeshOptimizer {
+
+void optimize(Mesh& mesh)
+{
+	mesh.acmrSource = computeACMR(mesh);
+	mesh.acmr = mesh.acmrSource;
+
+	// Leave malformed meshes as they are
+	for (unsigned int index : mesh.indices) {
+		if (index >= mesh.vertices.size())
+			return;
+	}
+	for (Primitive const& prim : mesh.primitives) {
+		if (static_cast<std::size_t>(prim.indexOffset) + prim.indexCount > mesh.indices.size())
+			return;
+	}
+
+	// Triangle order, per primitive so the draw ranges stay valid
+	for (Primitive const& prim : mesh.primitives)
+		optimizeTriangleOrder(mesh.indices.data() + prim.indexOffset, prim.indexCount);
+
+	// Vertex order, by first use in the index buffer
+	std::vector<unsigned int> remap(mesh.vertices.size(), k_unused);
+	unsigned int vertexCount = 0;
+	for (unsigned int& index : mesh.indices) {
+		if (remap[index] == k_unused)
+			remap[index] = vertexCount++;
+		index = remap[index];
+	}
+
+	std::vector<Vertex> vertices(vertexCount);
+	for (std::size_t v = 0; v < mesh.vertices.size(); ++v) {
+		if (remap[v] != k_unused)
+			vertices[remap[v]] = mesh.vertices[v];
+	}
+	mesh.vertices = std::move(vertices);
+
+	mesh.acmr = computeACMR(mesh);
+}
+
+void optimizeTriangleOrder(unsigned int* indices, std::size_t count)
+{
+	if (count < 6 || count % 3 != 0)
+		return;
+
+	auto [minIt, maxIt] = std::minmax_element(indices, indices + count);
+	reorderTriangles(indices, count, *minIt, static_cast<std::size_t>(*maxIt - *minIt) + 1);
+}
+
+float computeACMR(unsigned int const* indices, std::size_t count, int cacheSize)
+{
+	std::size_t triangles = count / 3;
+	return triangles > 0 ? static_cast<float>(countCacheMisses(indices, count, cacheSize)) / triangles : 0.0f;
+}
+
+float computeACMR(Mesh const& mesh)
+{
+	std::size_t misses = 0;
+	std::size_t triangles = 0;
+	for (Primitive const& prim : mesh.primitives) {
+		if (static_cast<std::size_t>(prim.indexOffset) + prim.indexCount > mesh.indices.size())
+			continue;
+		misses += countCacheMisses(mesh.indices.data() + prim.indexOffset, prim.indexCount, k_simulatedCacheSize);
+		triangles += prim.indexCount / 3;
+	}
+	return triangles > 0 ? static_cast<float>(misses) / triangles : 0.0f;
+}
+
+} // namespace MeshOptimizer
@@ -0,0 +1,331 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.hpp"
+#include "MeshOptimizer.hpp"
+#include "Vertex.hpp"
+
+namespace {
+// Cosine of the largest rotation a collapse may give a remaining triangle, so triangles don't flip or fold over several steps
+constexpr float k_maxNormalTurn = 0.25f;
+
+// Symmetric 4x4 matrix of the plane equations around a vertex, the error of a point is its summed squared plane distance
+struct Quadric {
+	double a2{}, ab{}, ac{}, ad{}, b2{}, bc{}, bd{}, c2{}, cd{}, d2{};
+
+	void addPlane(glm::vec3 const& n, float d, double weight)
+	{
+		a2 += weight * n.x * n.x;
+		ab += weight * n.x * n.y;
+		ac += weight * n.x * n.z;
+		ad += weight * n.x * d;
+		b2 += weight * n.y * n.y;
+		bc += weight * n.y * n.z;
+		bd += weight * n.y * d;
+		c2 += weight * n.z * n.z;
+		cd += weight * n.z * d;
+		d2 += weight * d * d;
+	}
+
+	Quadric& operator+=(Quadric const& o)
+	{
+		a2 += o.a2, ab += o.ab, ac += o.ac, ad += o.ad, b2 += o.b2, bc += o.bc, bd += o.bd, c2 += o.c2, cd += o.cd, d2 += o.d2;
+		return *this;
+	}
+
+	double evaluate(glm::vec3 const& p) const
+	{
+		double x = p.x, y = p.y, z = p.z;
+		return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x + b2 * y * y + 2 * bc * y * z + 2 * bd * y + c2 * z * z + 2 * cd * z + d2;
+	}
+};
+
+struct Collapse {
+	double cost;
+	std::uint32_t from;
+	std::uint32_t to;
+	std::uint32_t fromVersion;
+	std::uint32_t toVersion;
+
+	bool operator>(Collapse const& o) const { return cost > o.cost; }
+};
+
+// Simplification state of one primitive, vertices are local to [firstVertex, firstVertex + vertexCount)
+class PrimitiveSimplifier {
+public:
+	PrimitiveSimplifier(Mesh const& mesh, unsigned int const* indices, std::size_t indexCount) : mesh_(mesh)
+	{
+		auto [minIt, maxIt] = std::minmax_element(indices, indices + indexCount);
+		firstVertex_ = *minIt;
+		std::size_t vertexCount = static_cast<std::size_t>(*maxIt - *minIt) + 1;
+
+		triangles_.resize(indexCount / 3);
+		for (std::size_t t = 0; t < triangles_.size(); ++t) {
+			for (int k = 0; k < 3; ++k)
+				triangles_[t][k] = indices[t * 3 + k] - firstVertex_;
+		}
+		aliveTriangles_ = triangles_.size();
+		triangleAlive_.assign(triangles_.size(), 1);
+
+		vertexTriangles_.resize(vertexCount);
+		quadrics_.resize(vertexCount);
+		locked_.assign(vertexCount, 0);
+		removed_.assign(vertexCount, 0);
+		versions_.assign(vertexCount, 0);
+
+		for (std::size_t t = 0; t < triangles_.size(); ++t) {
+			auto const& tri = triangles_[t];
+			glm::vec3 p0 = getPosition_(tri[0]), p1 = getPosition_(tri[1]), p2 = getPosition_(tri[2]);
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float doubleArea = glm::length(n);
+
+			// Area weighted, so large faces hold their shape over the small ones
+			if (doubleArea > 0.0f) {
+				n = n / doubleArea;
+				for (int k = 0; k < 3; ++k)
+					quadrics_[tri[k]].addPlane(n, -glm::dot(n, p0), 0.5 * doubleArea);
+			}
+			for (int k = 0; k < 3; ++k)
+				vertexTriangles_[tri[k]].push_back(static_cast<std::uint32_t>(t));
+		}
+
+		lockBordersAndSeams_();
+
+		for (std::uint32_t v = 0; v < vertexCount; ++v)
+			pushCollapses_(v);
+	}
+
+	std::size_t getTriangleCount() const { return aliveTriangles_; }
+
+	// Collapse edges until the triangle count reaches the target or nothing can collapse anymore
+	void simplify(std::size_t targetTriangles)
+	{
+		while (aliveTriangles_ > targetTriangles && !heap_.empty()) {
+			Collapse c = heap_.top();
+			heap_.pop();
+
+			if (removed_[c.from] || removed_[c.to] || versions_[c.from] != c.fromVersion || versions_[c.to] != c.toVersion)
+				continue;
+			if (!canCollapse_(c.from, c.to))
+				continue;
+
+			collapse_(c.from, c.to);
+		}
+	}
+
+	void appendTriangles(std::vector<unsigned int>& out) const
+	{
+		for (std::size_t t = 0; t < triangles_.size(); ++t) {
+			if (!triangleAlive_[t])
+				continue;
+			for (int k = 0; k < 3; ++k)
+				out.push_back(triangles_[t][k] + firstVertex_);
+		}
+	}
+
+private:
+	Mesh const& mesh_;
+	unsigned int firstVertex_{};
+
+	std::vector<std::array<std::uint32_t, 3>> triangles_;
+	std::vector<char> triangleAlive_;
+	std::size_t aliveTriangles_{};
+
+	std::vector<std::vector<std::uint32_t>> vertexTriangles_; // Dead triangles are skipped, not removed
+	std::vector<Quadric> quadrics_;
+	std::vector<char> locked_;
+	std::vector<char> removed_;
+	std::vector<std::uint32_t> versions_; // Bumped when the neighbourhood changes, outdated heap entries are dropped
+
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap_;
+
+	glm::vec3 const& getPosition_(std::uint32_t v) const { return mesh_.vertices[v + firstVertex_].position; }
+
+	void lockBordersAndSeams_()
+	{
+		// Seams, several vertices sharing one position with different normals or UVs
+		std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> positions;
+		auto hashPosition = [](glm::vec3 const& p) {
+			std::uint32_t bits[3];
+			std::memcpy(bits, &p.x, sizeof(float));
+			std::memcpy(bits + 1, &p.y, sizeof(float));
+			std::memcpy(bits + 2, &p.z, sizeof(float));
+			return (static_cast<std::uint64_t>(bits[0]) * 73856093u) ^ (static_cast<std::uint64_t>(bits[1]) * 19349663u) ^
+						 (static_cast<std::uint64_t>(bits[2]) * 83492791u);
+		};
+		for (std::uint32_t v = 0; v < vertexTriangles_.size(); ++v) {
+			if (vertexTriangles_[v].empty())
+				continue;
+
+			auto& shared = positions[hashPosition(getPosition_(v))];
+			for (std::uint32_t other : shared) {
+				if (getPosition_(other) == getPosition_(v))
+					locked_[v] = locked_[other] = 1;
+			}
+			shared.push_back(v);
+		}
+
+		// Borders and non-manifold edges, used by other than two triangles
+		std::unordered_map<std::uint64_t, int> edges;
+		auto edgeKey = [](std::uint32_t a, std::uint32_t b) { return (static_cast<std::uint64_t>(std::min(a, b)) << 32) | std::max(a, b); };
+		for (auto const& tri : triangles_) {
+			for (int k = 0; k < 3; ++k)
+				edges[edgeKey(tri[k], tri[(k + 1) % 3])]++;
+		}
+		for (auto const& [key, count] : edges) {
+			if (count != 2) {
+				locked_[key >> 32] = 1;
+				locked_[key & 0xFFFFFFFFu] = 1;
+			}
+		}
+	}
+
+	template <typename Fn>
+	void forEachNeighbour_(std::uint32_t v, Fn&& fn) const
+	{
+		for (std::uint32_t t : vertexTriangles_[v]) {
+			if (!triangleAlive_[t])
+				continue;
+			for (std::uint32_t w : triangles_[t]) {
+				if (w != v)
+					fn(w);
+			}
+		}
+	}
+
+	void pushCollapses_(std::uint32_t v)
+	{
+		if (locked_[v] || removed_[v])
+			return;
+
+		forEachNeighbour_(v, [&](std::uint32_t w) {
+			Quadric q = quadrics_[v];
+			q += quadrics_[w];
+			heap_.push(Collapse{q.evaluate(getPosition_(w)), v, w, versions_[v], versions_[w]});
+		});
+	}
+
+	bool canCollapse_(std::uint32_t from, std::uint32_t to) const
+	{
+		// Link condition: the two vertices may only share the neighbours of the triangles on their edge, otherwise the surface pinches
+		std::vector<std::uint32_t> fromNeighbours, toNeighbours;
+		forEachNeighbour_(from, [&](std::uint32_t w) { fromNeighbours.push_back(w); });
+		forEachNeighbour_(to, [&](std::uint32_t w) { toNeighbours.push_back(w); });
+		std::sort(fromNeighbours.begin(), fromNeighbours.end());
+		std::sort(toNeighbours.begin(), toNeighbours.end());
+		fromNeighbours.erase(std::unique(fromNeighbours.begin(), fromNeighbours.end()), fromNeighbours.end());
+		toNeighbours.erase(std::unique(toNeighbours.begin(), toNeighbours.end()), toNeighbours.end());
+
+		std::size_t shared = 0;
+		std::size_t edgeTriangles = 0;
+		for (std::uint32_t w : fromNeighbours)
+			shared += std::binary_search(toNeighbours.begin(), toNeighbours.end(), w);
+		for (std::uint32_t t : vertexTriangles_[from]) {
+			auto const& tri = triangles_[t];
+			if (triangleAlive_[t] && (tri[0] == to || tri[1] == to || tri[2] == to))
+				edgeTriangles++;
+		}
+		if (edgeTriangles == 0 || shared > edgeTriangles)
+			return false;
+
+		// No remaining triangle may flip over or turn too far
+		glm::vec3 const& target = getPosition_(to);
+		for (std::uint32_t t : vertexTriangles_[from]) {
+			auto const& tri = triangles_[t];
+			if (!triangleAlive_[t] || tri[0] == to || tri[1] == to || tri[2] == to)
+				continue;
+
+			glm::vec3 p[3] = {getPosition_(tri[0]), getPosition_(tri[1]), getPosition_(tri[2])};
+			glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+			for (int k = 0; k < 3; ++k) {
+				if (tri[k] == from)
+					p[k] = target;
+			}
+			glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+			if (glm::dot(before, after) <= k_maxNormalTurn * glm::length(before) * glm::length(after))
+				return false;
+		}
+		return true;
+	}
+
+	void collapse_(std::uint32_t from, std::uint32_t to)
+	{
+		quadrics_[to] += quadrics_[from];
+		removed_[from] = 1;
+
+		for (std::uint32_t t : vertexTriangles_[from]) {
+			if (!triangleAlive_[t])
+				continue;
+
+			auto& tri = triangles_[t];
+			if (tri[0] == to || tri[1] == to || tri[2] == to) {
+				triangleAlive_[t] = 0;
+				aliveTriangles_--;
+				continue;
+			}
+			for (std::uint32_t& v : tri) {
+				if (v == from)
+					v = to;
+			}
+			vertexTriangles_[to].push_back(t);
+		}
+		vertexTriangles_[from].clear();
+
+		// Every vertex around the merged one has new edges or a new quadric to pair with
+		std::vector<std::uint32_t> affected{to};
+		forEachNeighbour_(to, [&](std::uint32_t w) { affected.push_back(w); });
+		std::sort(affected.begin(), affected.end());
+		affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+		for (std::uint32_t v : affected)
+			versions_[v]++;
+		for (std::uint32_t v : affected)
+			pushCollapses_(v);
+	}
+};
+} // namespace
+
+namespace MeshSimplifier {
+
+void generateLods(Mesh& mesh)
+{
+	for (unsigned int index : mesh.indices) {
+		if (index >= mesh.vertices.size())
+			return;
+	}
+
+	for (Primitive& prim : mesh.primitives) {
+		prim.lods.clear();
+		if (prim.indexCount / 3 < k_minTriangles || prim.indexCount % 3 != 0 || static_cast<std::size_t>(prim.indexOffset) + prim.indexCount > mesh.indices.size())
+			continue;
+
+		PrimitiveSimplifier simplifier(mesh, mesh.indices.data() + prim.indexOffset, prim.indexCount);
+		std::size_t previousTriangles = simplifier.getTriangleCount();
+
+		for (int level = 0; level < k_maxLods; ++level) {
+			simplifier.simplify(static_cast<std::size_t>(previousTriangles * k_lodRatio));
+
+			std::size_t triangles = simplifier.getTriangleCount();
+			if (triangles == 0 || triangles > previousTriangles * k_minReduction)
+				break;
+
+			// The level goes to the end of the index buffer, in vertex cache order like the full detail one
+			Primitive::Lod lod{static_cast<unsigned int>(mesh.indices.size()), static_cast<unsigned int>(triangles * 3)};
+			simplifier.appendTriangles(mesh.indices);
+			MeshOptimizer::optimizeTriangleOrder(mesh.indices.data() + lod.indexOffset, lod.indexCount);
+			prim.lods.push_back(lod);
+
+			previousTriangles = triangles;
+		}
+	}
+}
+
+} // namespace MeshSimplifier
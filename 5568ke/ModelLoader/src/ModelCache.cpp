@@ -0,0 +1,542 @@
+#include "ModelCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include "AnimationClip.hpp"
+#include "BlinnPhongMaterial.hpp"
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+#include "Model.hpp"
+#include "Node.hpp"
+#include "Primitive.hpp"
+#include "Vertex.hpp"
+
+namespace {
+constexpr std::size_t k_arrayAlignment = 16;
+
+// Appends plain values and arrays, every array starting aligned so it can be used in place from a mapping
+class BlobWriter {
+public:
+	std::vector<char> bytes;
+
+	template <typename T>
+	void pod(T const& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		char const* p = reinterpret_cast<char const*>(&value);
+		bytes.insert(bytes.end(), p, p + sizeof(T));
+	}
+
+	template <typename T>
+	void array(T const* data, std::size_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		pod(static_cast<std::uint64_t>(count));
+		bytes.resize((bytes.size() + k_arrayAlignment - 1) / k_arrayAlignment * k_arrayAlignment, 0);
+		char const* p = reinterpret_cast<char const*>(data);
+		bytes.insert(bytes.end(), p, p + count * sizeof(T));
+	}
+
+	template <typename T>
+	void array(std::vector<T> const& values)
+	{
+		array(values.data(), values.size());
+	}
+
+	void string(std::string const& value) { array(value.data(), value.size()); }
+};
+
+// Reads back what BlobWriter wrote, every read fails once the data runs out
+class BlobReader {
+public:
+	BlobReader(unsigned char const* data, std::size_t size) : begin_(data), cur_(data), end_(data + size) {}
+
+	bool ok() const { return ok_; }
+	std::size_t offset() const { return static_cast<std::size_t>(cur_ - begin_); }
+
+	// Element count of a list, every element takes at least one byte so a larger count means a corrupt file
+	std::size_t count()
+	{
+		auto value = static_cast<std::size_t>(pod<std::uint32_t>());
+		if (value > static_cast<std::size_t>(end_ - cur_)) {
+			ok_ = false;
+			return 0;
+		}
+		return value;
+	}
+
+	template <typename T>
+	T pod()
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		T value{};
+		if (take_(sizeof(T)))
+			std::memcpy(&value, cur_ - sizeof(T), sizeof(T));
+		return value;
+	}
+
+	// Pointer into the blob, valid as long as the mapping
+	template <typename T>
+	T const* view(std::size_t& count)
+	{
+		count = static_cast<std::size_t>(pod<std::uint64_t>());
+		std::size_t offset = static_cast<std::size_t>(cur_ - begin_);
+		std::size_t padding = (k_arrayAlignment - offset % k_arrayAlignment) % k_arrayAlignment;
+		if (!take_(padding) || count > static_cast<std::size_t>(end_ - cur_) / sizeof(T) || !take_(count * sizeof(T))) {
+			count = 0;
+			return nullptr;
+		}
+		return reinterpret_cast<T const*>(cur_ - count * sizeof(T));
+	}
+
+	template <typename T>
+	std::vector<T> array()
+	{
+		std::size_t count = 0;
+		T const* data = view<T>(count);
+		std::vector<T> values(count);
+		if (count > 0)
+			std::memcpy(values.data(), data, count * sizeof(T));
+		return values;
+	}
+
+	std::string string()
+	{
+		std::size_t count = 0;
+		char const* data = view<char>(count);
+		return data ? std::string(data, count) : std::string();
+	}
+
+private:
+	unsigned char const* begin_;
+	unsigned char const* cur_;
+	unsigned char const* end_;
+	bool ok_{true};
+
+	bool take_(std::size_t bytes)
+	{
+		if (!ok_ || bytes > static_cast<std::size_t>(end_ - cur_)) {
+			ok_ = false;
+			return false;
+		}
+		cur_ += bytes;
+		return true;
+	}
+};
+
+// FNV-1a of a whole file, 0 when it can't be read
+std::uint64_t hashFile(std::filesystem::path const& path)
+{
+	MappedFile file(path.string());
+	if (!file.isOpen())
+		return 0;
+
+	std::uint64_t hash = 14695981039346656037ull;
+	for (std::size_t i = 0; i < file.size(); ++i) {
+		hash ^= file.data()[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+std::int64_t getWriteTime(std::filesystem::path const& path, std::error_code& ec)
+{
+	return static_cast<std::int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+}
+
+// Dependencies are stored relative to the source directory
+bool writeDependencies(BlobWriter& out, std::filesystem::path const& baseDir, std::vector<std::filesystem::path> const& dependencies)
+{
+	out.pod(static_cast<std::uint32_t>(dependencies.size()));
+	for (auto const& dependency : dependencies) {
+		std::error_code ec;
+		std::uint64_t size = std::filesystem::file_size(dependency, ec);
+		std::int64_t writeTime = getWriteTime(dependency, ec);
+		if (ec)
+			return false;
+
+		out.string(dependency.lexically_relative(baseDir).generic_string());
+		out.pod(size);
+		out.pod(writeTime);
+		out.pod(hashFile(dependency));
+	}
+	return true;
+}
+
+// A stamp whose mtime is out of date, the byte offset of the stored mtime in the cache and the current one
+struct StaleWriteTime {
+	std::size_t offset;
+	std::int64_t writeTime;
+};
+
+bool checkDependencies(BlobReader& in, std::filesystem::path const& baseDir, std::vector<StaleWriteTime>& staleWriteTimes)
+{
+	std::size_t count = in.count();
+	for (std::size_t i = 0; i < count && in.ok(); ++i) {
+		std::filesystem::path dependency = baseDir / in.string();
+		auto size = in.pod<std::uint64_t>();
+		std::size_t writeTimeOffset = in.offset();
+		auto writeTime = in.pod<std::int64_t>();
+		auto hash = in.pod<std::uint64_t>();
+
+		std::error_code ec;
+		if (std::filesystem::file_size(dependency, ec) != size || ec)
+			return false;
+
+		// Touched but maybe not changed (checkout, copy), compare the content
+		std::int64_t currentWriteTime = getWriteTime(dependency, ec);
+		if (currentWriteTime != writeTime) {
+			if (ec || hashFile(dependency) != hash)
+				return false;
+			staleWriteTimes.push_back(StaleWriteTime{writeTimeOffset, currentWriteTime});
+		}
+	}
+	return in.ok();
+}
+
+// Store the current mtimes of the files whose content matched, so the next launch doesn't hash them again
+void refreshWriteTimes(std::filesystem::path const& cachePath, std::vector<StaleWriteTime> const& staleWriteTimes)
+{
+	std::fstream file(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+	for (StaleWriteTime const& stale : staleWriteTimes) {
+		if (!file.seekp(static_cast<std::streamoff>(stale.offset)))
+			return;
+		file.write(reinterpret_cast<char const*>(&stale.writeTime), sizeof(stale.writeTime));
+	}
+}
+
+int findTextureIndex(Model const& model, Texture const* texture)
+{
+	auto const& textures = model.asset->textures;
+	auto it = std::find_if(textures.begin(), textures.end(), [texture](auto const& handle) { return handle.get() == texture; });
+	return texture && it != textures.end() ? static_cast<int>(it - textures.begin()) : -1;
+}
+} // namespace
+
+namespace ModelCache {
+
+std::filesystem::path getCachePath(std::string const& sourcePath) { return std::filesystem::path(sourcePath + ".modelcache"); }
+
+bool write(std::string const& sourcePath, Model const& model, std::vector<TextureRecord> const& textures,
+					 std::vector<std::filesystem::path> const& dependencies, float bakeSampleRate, bool compressedTextures,
+					 bool optimizedMeshes, bool lods)
+{
+	if (!model.asset || textures.size() != model.asset->textures.size())
+		return false;
+
+	ModelAsset const& asset = *model.asset;
+	BlobWriter out;
+
+	// Header
+	out.pod(k_magic);
+	out.pod(k_version);
+	out.pod(static_cast<std::uint32_t>(sizeof(Vertex)));
+	out.pod(bakeSampleRate);
+	out.pod(static_cast<std::uint8_t>(compressedTextures));
+	out.pod(static_cast<std::uint8_t>(optimizedMeshes));
+	out.pod(static_cast<std::uint8_t>(lods));
+	if (!writeDependencies(out, std::filesystem::path(sourcePath).parent_path(), dependencies))
+		return false;
+
+	// Textures
+	out.pod(static_cast<std::uint32_t>(textures.size()));
+	for (auto const& record : textures) {
+		bool embedded = record.key.rfind("file:", 0) != 0 && record.compressed.empty();
+		out.string(record.key);
+		out.pod(static_cast<std::uint32_t>(record.type));
+		out.string(record.uri);
+		out.pod(static_cast<std::uint8_t>(embedded));
+		out.pod(static_cast<std::int32_t>(record.image.width));
+		out.pod(static_cast<std::int32_t>(record.image.height));
+		out.pod(static_cast<std::int32_t>(record.image.component));
+		out.pod(static_cast<std::int32_t>(record.image.bits));
+		out.pod(static_cast<std::int32_t>(record.image.pixel_type));
+		if (embedded)
+			out.array(record.image.image);
+
+		out.pod(record.compressed.format);
+		if (!record.compressed.empty()) {
+			out.array(record.compressed.levels);
+			out.array(record.compressed.data);
+		}
+	}
+
+	// Meshes, one material per primitive
+	out.pod(static_cast<std::uint32_t>(asset.meshes.size()));
+	for (Mesh const& mesh : asset.meshes) {
+		out.array(mesh.vertices);
+		out.array(mesh.indices);
+		out.pod(mesh.acmrSource);
+		out.pod(mesh.acmr);
+		out.pod(static_cast<std::uint32_t>(mesh.primitives.size()));
+		for (Primitive const& prim : mesh.primitives) {
+			auto const* material = dynamic_cast<BlinnPhongMaterial const*>(prim.material);
+			out.pod(static_cast<std::uint32_t>(prim.indexOffset));
+			out.pod(static_cast<std::uint32_t>(prim.indexCount));
+			out.array(prim.lods);
+			out.pod(static_cast<std::uint8_t>(prim.doubleSided));
+			out.pod(material ? material->albedo : glm::vec3(1.0f));
+			out.pod(material ? material->shininess : 32.0f);
+			out.pod(static_cast<std::int32_t>(material ? findTextureIndex(model, material->diffuseMap) : -1));
+			out.pod(static_cast<std::int32_t>(material ? findTextureIndex(model, material->overlayMap) : -1));
+		}
+	}
+	out.array(asset.meshNodeIndices);
+	out.array(asset.boundingBoxes);
+
+	// Node tree in the rest pose, children by node index
+	out.pod(static_cast<std::uint32_t>(model.nodes.size()));
+	for (auto const& node : model.nodes) {
+		out.pod(static_cast<std::uint8_t>(node != nullptr));
+		if (!node)
+			continue;
+
+		std::vector<std::int32_t> children;
+		for (auto const& child : node->children) {
+			if (child)
+				children.push_back(child->nodeNum);
+		}
+		out.pod(static_cast<std::int32_t>(node->nodeNum));
+		out.string(node->nodeName);
+		out.pod(node->translation);
+		out.pod(node->rotation);
+		out.pod(node->scale);
+		out.array(children);
+	}
+	out.pod(static_cast<std::int32_t>(model.rootNode ? model.rootNode->nodeNum : -1));
+
+	// Skin
+	out.array(asset.inverseBindMatrices);
+	out.array(asset.jointNodes);
+	out.array(asset.skinJointOffsets);
+	out.array(asset.jointBindBBoxes);
+	out.pod(asset.unskinnedBindBBox);
+
+	// Baked animation tracks
+	out.pod(static_cast<std::uint32_t>(asset.animations.size()));
+	for (auto const& clip : asset.animations) {
+		AnimationClip::BakedTrack const& track = clip->getBakedTrack();
+		out.string(clip->clipName);
+		out.pod(track.duration);
+		out.pod(track.sampleRate);
+		out.pod(static_cast<std::uint64_t>(track.frameCount));
+		out.array(track.nodeIndices);
+		out.array(track.translations);
+		out.array(track.rotations);
+		out.array(track.scales);
+	}
+
+	// Written aside then renamed, so a reader never maps a half written file
+	std::filesystem::path cachePath = getCachePath(sourcePath);
+	std::filesystem::path tempPath = cachePath;
+	tempPath += ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.write(out.bytes.data(), static_cast<std::streamsize>(out.bytes.size())))
+			return false;
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempPath, cachePath, ec);
+	if (ec)
+		std::filesystem::remove(tempPath, ec);
+	return !ec;
+}
+
+std::shared_ptr<Model> read(std::string const& sourcePath, float bakeSampleRate, bool compressedTextures, bool optimizedMeshes, bool lods,
+													 std::function<Texture*(TextureRecord const&)> const& resolveTexture)
+{
+	std::filesystem::path cachePath = getCachePath(sourcePath);
+	MappedFile file(cachePath.string());
+	if (!file.isOpen())
+		return nullptr;
+
+	BlobReader in(file.data(), file.size());
+
+	// Header
+	if (in.pod<std::uint32_t>() != k_magic || in.pod<std::uint32_t>() != k_version || in.pod<std::uint32_t>() != sizeof(Vertex) ||
+			in.pod<float>() != bakeSampleRate || (in.pod<std::uint8_t>() != 0) != compressedTextures ||
+			(in.pod<std::uint8_t>() != 0) != optimizedMeshes || (in.pod<std::uint8_t>() != 0) != lods)
+		return nullptr;
+	std::vector<StaleWriteTime> staleWriteTimes;
+	if (!checkDependencies(in, std::filesystem::path(sourcePath).parent_path(), staleWriteTimes))
+		return nullptr;
+
+	std::shared_ptr<Model> model = std::make_shared<Model>();
+	model->asset = std::make_shared<ModelAsset>();
+	ModelAsset& asset = *model->asset;
+	asset.sourcePath = sourcePath;
+
+	// Textures, resolved once the whole file is known to be valid
+	std::vector<TextureRecord> textures(in.count());
+	for (auto& record : textures) {
+		record.key = in.string();
+		record.type = static_cast<TextureType>(in.pod<std::uint32_t>());
+		record.uri = in.string();
+		bool embedded = in.pod<std::uint8_t>() != 0;
+		record.image.width = in.pod<std::int32_t>();
+		record.image.height = in.pod<std::int32_t>();
+		record.image.component = in.pod<std::int32_t>();
+		record.image.bits = in.pod<std::int32_t>();
+		record.image.pixel_type = in.pod<std::int32_t>();
+		if (embedded)
+			record.image.image = in.array<unsigned char>();
+
+		record.compressed.format = in.pod<TextureCompressor::Format>();
+		if (record.compressed.format > TextureCompressor::Format::BC3)
+			return nullptr;
+		if (record.compressed.format != TextureCompressor::Format::None) {
+			record.compressed.levels = in.array<TextureCompressor::MipLevel>();
+			record.compressed.data = in.array<unsigned char>();
+			for (auto const& level : record.compressed.levels) {
+				if (level.offset > record.compressed.data.size() || level.size > record.compressed.data.size() - level.offset)
+					return nullptr;
+			}
+		}
+		if (!in.ok())
+			return nullptr;
+	}
+
+	// Meshes, the materials are created once the whole file is read
+	struct MaterialRecord {
+		Primitive* prim;
+		glm::vec3 albedo;
+		float shininess;
+		std::int32_t diffuse;
+		std::int32_t overlay;
+	};
+	std::vector<MaterialRecord> materials;
+
+	asset.meshes.resize(in.count());
+	for (Mesh& mesh : asset.meshes) {
+		mesh.vertices = in.array<Vertex>();
+		mesh.indices = in.array<unsigned int>();
+		// An index past the vertex buffer would make the vertex fetch read out of bounds
+		if (std::any_of(mesh.indices.begin(), mesh.indices.end(), [&](unsigned int index) { return index >= mesh.vertices.size(); }))
+			return nullptr;
+		mesh.acmrSource = in.pod<float>();
+		mesh.acmr = in.pod<float>();
+		mesh.primitives.resize(in.count());
+		for (Primitive& prim : mesh.primitives) {
+			prim.indexOffset = in.pod<std::uint32_t>();
+			prim.indexCount = in.pod<std::uint32_t>();
+			prim.lods = in.array<Primitive::Lod>();
+			prim.doubleSided = in.pod<std::uint8_t>() != 0;
+			prim.material = nullptr;
+
+			MaterialRecord record;
+			record.prim = &prim;
+			record.albedo = in.pod<glm::vec3>();
+			record.shininess = in.pod<float>();
+			record.diffuse = in.pod<std::int32_t>();
+			record.overlay = in.pod<std::int32_t>();
+			materials.push_back(record);
+
+			// A range past the index buffer would make the draw read out of bounds
+			auto inBounds = [&](std::size_t offset, std::size_t count) { return offset + count <= mesh.indices.size(); };
+			if (!inBounds(prim.indexOffset, prim.indexCount))
+				return nullptr;
+			for (Primitive::Lod const& lod : prim.lods) {
+				if (!inBounds(lod.indexOffset, lod.indexCount))
+					return nullptr;
+			}
+		}
+		if (!in.ok())
+			return nullptr;
+	}
+	asset.meshNodeIndices = in.array<int>();
+	asset.boundingBoxes = in.array<BoundingBox>();
+
+	// Node tree
+	model->nodes.resize(in.count());
+	std::vector<std::vector<std::int32_t>> children(model->nodes.size());
+	for (std::size_t i = 0; i < model->nodes.size() && in.ok(); ++i) {
+		if (in.pod<std::uint8_t>() == 0)
+			continue;
+
+		auto node = std::make_shared<Node>(in.pod<std::int32_t>());
+		node->nodeName = in.string();
+		node->translation = in.pod<glm::vec3>();
+		node->rotation = in.pod<glm::quat>();
+		node->scale = in.pod<glm::vec3>();
+		children[i] = in.array<std::int32_t>();
+		model->nodes[i] = node;
+	}
+	for (std::size_t i = 0; i < model->nodes.size(); ++i) {
+		for (std::int32_t child : children[i]) {
+			if (!model->nodes[i] || child < 0 || static_cast<std::size_t>(child) >= model->nodes.size() || !model->nodes[child])
+				return nullptr;
+			model->nodes[i]->children.push_back(model->nodes[child]);
+		}
+	}
+	auto rootIndex = in.pod<std::int32_t>();
+	if (rootIndex >= 0 && static_cast<std::size_t>(rootIndex) < model->nodes.size())
+		model->rootNode = model->nodes[rootIndex];
+
+	// Skin
+	asset.inverseBindMatrices = in.array<glm::mat4>();
+	asset.jointNodes = in.array<int>();
+	asset.skinJointOffsets = in.array<int>();
+	if (asset.jointNodes.size() != asset.inverseBindMatrices.size())
+		return nullptr;
+	model->jointMatrices.assign(asset.jointNodes.size(), glm::mat4(1.0f));
+	asset.jointBindBBoxes = in.array<BoundingBox>();
+	asset.unskinnedBindBBox = in.pod<BoundingBox>();
+
+	// Baked animation tracks
+	asset.animations.resize(in.count());
+	for (auto& clip : asset.animations) {
+		clip = std::make_shared<AnimationClip>(in.string());
+
+		AnimationClip::BakedTrack track;
+		track.duration = in.pod<float>();
+		track.sampleRate = in.pod<float>();
+		track.frameCount = static_cast<std::size_t>(in.pod<std::uint64_t>());
+		track.nodeIndices = in.array<int>();
+		track.translations = in.array<glm::vec3>();
+		track.rotations = in.array<glm::quat>();
+		track.scales = in.array<glm::vec3>();
+
+		// Every slot must have a value in every frame and point at an existing node
+		std::size_t samples = track.frameCount * track.nodeIndices.size();
+		if (track.translations.size() != samples || track.rotations.size() != samples || track.scales.size() != samples)
+			return nullptr;
+		for (int nodeIndex : track.nodeIndices) {
+			if (nodeIndex < 0 || static_cast<std::size_t>(nodeIndex) >= model->nodes.size() || !model->nodes[nodeIndex])
+				return nullptr;
+		}
+		clip->setBakedTrack(std::move(track));
+	}
+
+	if (!in.ok())
+		return nullptr;
+
+	// Resolve the textures last, nothing is handed to the texture cache for a file rejected above
+	std::vector<Texture*> resolved;
+	for (auto const& record : textures)
+		resolved.push_back(resolveTexture(record));
+
+	auto getTexture = [&resolved](std::int32_t index) { return index >= 0 && static_cast<std::size_t>(index) < resolved.size() ? resolved[index] : nullptr; };
+	for (auto const& record : materials) {
+		auto* material = new BlinnPhongMaterial();
+		material->albedo = record.albedo;
+		material->shininess = record.shininess;
+		material->diffuseMap = getTexture(record.diffuse);
+		material->overlayMap = getTexture(record.overlay);
+		record.prim->material = material;
+	}
+
+	NodeUtil::buildNodeHierarchy(*model);
+
+	// Everything was copied out of the mapping, which has to be closed before the file is written on Windows
+	if (!staleWriteTimes.empty()) {
+		file.close();
+		refreshWriteTimes(cachePath, staleWriteTimes);
+	}
+	return model;
+}
+
+} // namespace ModelCache
@@ -0,0 +1,82 @@
+#include "TextureCache.hpp"
+
+#include "GLUploadQueue.hpp"
+#include "include_5568ke.hpp"
+
+std::shared_ptr<Texture> TextureCache::find(std::string const& key)
+{
+	std::lock_guard lock(mutex_);
+	return find_(key);
+}
+
+std::shared_ptr<Texture> TextureCache::insert(std::string const& key, Texture* texture, std::size_t bytes)
+{
+	std::lock_guard lock(mutex_);
+	return insert_(key, texture, bytes);
+}
+
+std::shared_ptr<Texture> TextureCache::findOrInsert(std::string const& key, std::function<std::pair<Texture*, std::size_t>()> const& create)
+{
+	std::lock_guard lock(mutex_);
+	if (std::shared_ptr<Texture> texture = find_(key))
+		return texture;
+
+	auto [texture, bytes] = create();
+	return insert_(key, texture, bytes);
+}
+
+TextureCache::Stats TextureCache::getStats()
+{
+	std::lock_guard lock(mutex_);
+	std::erase_if(entries_, [](auto const& entry) { return entry.second.texture.expired(); });
+
+	Stats stats;
+	stats.residentTextures = entries_.size();
+	for (auto const& [key, entry] : entries_)
+		stats.residentBytes += entry.bytes;
+	stats.hits = hits_;
+	stats.uploads = uploads_;
+	return stats;
+}
+
+void TextureCache::clear()
+{
+	std::lock_guard lock(mutex_);
+	entries_.clear();
+}
+
+std::shared_ptr<Texture> TextureCache::find_(std::string const& key)
+{
+	auto it = entries_.find(key);
+	if (it == entries_.end())
+		return nullptr;
+
+	std::shared_ptr<Texture> texture = it->second.texture.lock();
+	if (!texture) {
+		entries_.erase(it);
+		return nullptr;
+	}
+
+	hits_++;
+	return texture;
+}
+
+std::shared_ptr<Texture> TextureCache::insert_(std::string const& key, Texture* texture, std::size_t bytes)
+{
+	// The GL texture lives as long as the last handle, which a loader thread may hold
+	std::shared_ptr<Texture> handle(texture, [](Texture* t) {
+		GLUploadQueue& uploadQueue = GLUploadQueue::getInstance();
+		if (t->id && !uploadQueue.isGLThread()) {
+			uploadQueue.push([id = t->id] { glDeleteTextures(1, &id); });
+			t->id = 0;
+		}
+
+		if (t->id)
+			glDeleteTextures(1, &t->id);
+		delete t;
+	});
+
+	entries_[key] = Entry{handle, bytes};
+	uploads_++;
+	return handle;
+}
@@ -0,0 +1,172 @@
+#include "TextureCompressor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string_view>
+
+#define STB_DXT_STATIC
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+// From EXT_texture_compression_s3tc, not part of the core profile headers
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace {
+std::atomic<bool> s_supported{false};
+
+std::size_t getBlockBytes(TextureCompressor::Format format) { return format == TextureCompressor::Format::BC1 ? 8 : 16; }
+
+// Expand to 4 channels, the block encoder always reads RGBA
+std::vector<unsigned char> toRGBA(tinygltf::Image const& image)
+{
+	std::size_t pixelCount = static_cast<std::size_t>(image.width) * image.height;
+	if (image.component == 4)
+		return image.image;
+
+	std::vector<unsigned char> rgba(pixelCount * 4, 255);
+	for (std::size_t i = 0; i < pixelCount; ++i)
+		std::memcpy(&rgba[i * 4], &image.image[i * 3], 3);
+	return rgba;
+}
+
+// Half size level, averaging 2x2 pixels (clamped at the edge of odd sizes)
+std::vector<unsigned char> downsample(std::vector<unsigned char> const& src, int width, int height, int nextWidth, int nextHeight)
+{
+	std::vector<unsigned char> dst(static_cast<std::size_t>(nextWidth) * nextHeight * 4);
+	for (int y = 0; y < nextHeight; ++y) {
+		int y0 = std::min(y * 2, height - 1);
+		int y1 = std::min(y * 2 + 1, height - 1);
+		for (int x = 0; x < nextWidth; ++x) {
+			int x0 = std::min(x * 2, width - 1);
+			int x1 = std::min(x * 2 + 1, width - 1);
+			for (int c = 0; c < 4; ++c) {
+				int sum = src[(static_cast<std::size_t>(y0) * width + x0) * 4 + c] + src[(static_cast<std::size_t>(y0) * width + x1) * 4 + c] +
+									src[(static_cast<std::size_t>(y1) * width + x0) * 4 + c] + src[(static_cast<std::size_t>(y1) * width + x1) * 4 + c];
+				dst[(static_cast<std::size_t>(y) * nextWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+			}
+		}
+	}
+	return dst;
+}
+
+// Encode one level block by block, partial blocks repeat the last row / column
+void compressLevel(std::vector<unsigned char> const& rgba, int width, int height, TextureCompressor::Format format, unsigned char* out)
+{
+	bool alpha = format == TextureCompressor::Format::BC3;
+	unsigned char block[16 * 4];
+	for (int by = 0; by < height; by += 4) {
+		for (int bx = 0; bx < width; bx += 4) {
+			for (int y = 0; y < 4; ++y) {
+				int sy = std::min(by + y, height - 1);
+				for (int x = 0; x < 4; ++x) {
+					int sx = std::min(bx + x, width - 1);
+					std::memcpy(&block[(y * 4 + x) * 4], &rgba[(static_cast<std::size_t>(sy) * width + sx) * 4], 4);
+				}
+			}
+			stb_compress_dxt_block(out, block, alpha ? 1 : 0, STB_DXT_HIGHQUAL);
+			out += getBlockBytes(format);
+		}
+	}
+}
+} // namespace
+
+namespace TextureCompressor {
+
+void detectSupport()
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+	std::vector<GLint> formats(std::max(count, 0));
+	if (!formats.empty())
+		glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+
+	bool bc1 = std::find(formats.begin(), formats.end(), GL_COMPRESSED_RGB_S3TC_DXT1_EXT) != formats.end();
+	bool bc3 = std::find(formats.begin(), formats.end(), GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) != formats.end();
+
+	// Some drivers only advertise the extension
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (GLint i = 0; i < extensionCount && !(bc1 && bc3); ++i) {
+		auto const* name = reinterpret_cast<char const*>(glGetStringi(GL_EXTENSIONS, i));
+		if (name && std::string_view(name) == "GL_EXT_texture_compression_s3tc")
+			bc1 = bc3 = true;
+	}
+
+	s_supported = bc1 && bc3;
+	// std::cout << "[TextureCompressor INFO] S3TC support: " << s_supported << std::endl;
+}
+
+bool isSupported() { return s_supported; }
+
+bool canCompress(tinygltf::Image const& image)
+{
+	return image.width > 0 && image.height > 0 && (image.component == 3 || image.component == 4) &&
+				 image.pixel_type == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE &&
+				 image.image.size() >= static_cast<std::size_t>(image.width) * image.height * image.component;
+}
+
+std::size_t estimateBytes(tinygltf::Image const& image)
+{
+	// BC3 is one byte per pixel, plus about a third for the mip chain
+	std::size_t levelBytes = static_cast<std::size_t>(std::max(image.width, 4)) * std::max(image.height, 4);
+	return levelBytes + levelBytes / 3;
+}
+
+CompressedImage compress(tinygltf::Image const& image)
+{
+	CompressedImage result;
+	if (!canCompress(image))
+		return result;
+
+	std::vector<unsigned char> rgba = toRGBA(image);
+
+	// BC1 keeps no alpha, use it when every pixel is opaque
+	result.format = Format::BC1;
+	for (std::size_t i = 3; i < rgba.size(); i += 4) {
+		if (rgba[i] != 255) {
+			result.format = Format::BC3;
+			break;
+		}
+	}
+
+	int width = image.width;
+	int height = image.height;
+	while (true) {
+		std::size_t blocks = static_cast<std::size_t>((width + 3) / 4) * ((height + 3) / 4);
+		MipLevel level{width, height, result.data.size(), blocks * getBlockBytes(result.format)};
+		result.data.resize(result.data.size() + level.size);
+		compressLevel(rgba, width, height, result.format, result.data.data() + level.offset);
+		result.levels.push_back(level);
+
+		if (width == 1 && height == 1)
+			break;
+
+		int nextWidth = std::max(width / 2, 1);
+		int nextHeight = std::max(height / 2, 1);
+		rgba = downsample(rgba, width, height, nextWidth, nextHeight);
+		width = nextWidth;
+		height = nextHeight;
+	}
+
+	return result;
+}
+
+GLenum getGLFormat(Format format)
+{
+	switch (format) {
+	case Format::BC1:
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case Format::BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	default:
+		return 0;
+	}
+}
+
+} // namespace TextureCompressor
@@ -20,6 +20,7 @@
 #include "GameObject.hpp"    // For GameObject (already in DialogSystem.hpp, but good for explicitness)
 #include "Model.hpp"         // For Model definition
 #include "AnimationClip.hpp" // For AnimationClip definition
+#include "AnimationSystem.hpp" // For AnimationSystem
 
 // -------- Implementation of DialogSystem methods --------
 
@@ -42,10 +43,12 @@ NPC& DialogSystem::addNPC(std::shared_ptr<GameObject> go, std::vector<std::share
         0,                          // totalScore
         false,                      // isPlayingIdleAnimation
         0.0f,                       // idleAnimationTime
-        -1                          // idleAnimationIndex
+        -1,                         // idleAnimationIndex
+        {}                          // idleAnimationCursor
     });
 
     if (npcs_.back().go) {
+		npcIndex_[npcs_.back().go.get()] = npcs_.size() - 1;
         std::cout << "[DialogSystem] Added NPC. GameObject name: '" << std::string(npcs_.back().go->name) << "'. Initializing idle animation." << std::endl;
 		initializeNPCIdleAnimation(npcs_.back());
 	} else {
@@ -80,10 +83,10 @@ void DialogSystem::initializeNPCIdleAnimation(NPC& npc)
 
 int DialogSystem::findIdleAnimationIndex(std::shared_ptr<GameObject> const& go)
 {
-	if (!go || !go->getModel() || go->getModel()->animations.empty()) {
+	if (!go || !go->getModel() || go->getModel()->asset->animations.empty()) {
 		return -1;
 	}
-	auto const& animations = go->getModel()->animations;
+	auto const& animations = go->getModel()->asset->animations;
 	for (size_t i = 0; i < animations.size(); ++i) {
         if (!animations[i]) continue; 
 		std::string clipName = animations[i]->clipName;
@@ -105,13 +108,12 @@ void DialogSystem::startIdleAnimation(NPC& npc)
 		return;
 	}
 	auto model = npc.go->getModel();
-	if (static_cast<size_t>(npc.idleAnimationIndex) >= model->animations.size() || !model->animations[npc.idleAnimationIndex]) {
+	if (static_cast<size_t>(npc.idleAnimationIndex) >= model->asset->animations.size() || !model->asset->animations[npc.idleAnimationIndex]) {
 		return;
 	}
 	npc.isPlayingIdleAnimation = true;
 	npc.idleAnimationTime = 0.0f;
-	model->animations[npc.idleAnimationIndex]->setAnimationFrame(model->nodes, 0.0f);
-	model->updateLocalMatrices();
+	AnimationSystem::getInstance().play(*model, npc.idleAnimationIndex, 0.0f);
 }
 
 void DialogSystem::updateNPCIdleAnimation(NPC& npc, float dt)
@@ -131,8 +133,8 @@ void DialogSystem::updateNPCIdleAnimation(NPC& npc, float dt)
 	}
 	if (npc.isPlayingIdleAnimation) {
 		auto model = npc.go->getModel();
-		if (static_cast<size_t>(npc.idleAnimationIndex) < model->animations.size() && model->animations[npc.idleAnimationIndex]) {
-			auto const& idleClip = model->animations[npc.idleAnimationIndex];
+		if (static_cast<size_t>(npc.idleAnimationIndex) < model->asset->animations.size() && model->asset->animations[npc.idleAnimationIndex]) {
+			auto const& idleClip = model->asset->animations[npc.idleAnimationIndex];
 			npc.idleAnimationTime += dt;
 			float duration = idleClip->getDuration();
 			if (duration > 0.0f) { 
@@ -140,14 +142,19 @@ void DialogSystem::updateNPCIdleAnimation(NPC& npc, float dt)
 			} else {
                 npc.idleAnimationTime = 0.0f; 
             }
-			idleClip->setAnimationFrame(model->nodes, npc.idleAnimationTime);
-			model->updateLocalMatrices();
+			AnimationSystem::getInstance().play(*model, npc.idleAnimationIndex, npc.idleAnimationTime, &npc.idleAnimationCursor); // Evaluated in parallel by AnimationSystem::update
 		} else {
             npc.isPlayingIdleAnimation = false;
         }
 	}
 }
 
+void DialogSystem::cleanup()
+{
+	npcs_.clear();
+	npcIndex_.clear();
+}
+
 void DialogSystem::update(Scene& scene, float dt)
 {
 	std::shared_ptr<GameObject> player = nullptr;
@@ -213,31 +220,27 @@ void DialogSystem::update(Scene& scene, float dt)
 		}
 		updateNPCIdleAnimation(npc_iter, dt); 
 
-		if (npc_iter.inDialog) {
-            if (npc_iter.showIcon) { 
-                npc_iter.showIcon = false;
-            }
-			continue;
-		}
-		
-		if (npc_iter.routeEnabled) { 
-            float distance = player->distanceTo(*npc_iter.go);
-            std::cout << "[DS_Update] NPC '" << std::string(npc_iter.go->name) 
-                      << "' (RouteEnabled): Dist to Player=" << distance;
-
-            float const INTERACTION_RANGE = 2.0f; 
-            if (distance <= INTERACTION_RANGE) {
-                npc_iter.showIcon = true;
-            } else {
-                npc_iter.showIcon = false;
-            }
-            std::cout << ", NewShowIcon: " << npc_iter.showIcon << std::endl;
-        } else { 
-            if (npc_iter.showIcon) { 
-                npc_iter.showIcon = false;
-            }
-        }
+		// Turned back on below when the proximity query finds the NPC in range and not in a dialog
+		npc_iter.showIcon = false;
 	}
+
+	// Only the objects around the player come back from the scene BVH, the NPCs among them are looked up directly
+	float const INTERACTION_RANGE = 2.0f;
+	scene.queryRadius(player->getWorldPosition(), INTERACTION_RANGE, [&](GameObject const& go) {
+		auto it = npcIndex_.find(&go);
+		if (it == npcIndex_.end())
+			return true;
+
+		NPC& npc = npcs_[it->second];
+		if (!npc.routeEnabled || npc.inDialog || !npc.go->visible)
+			return true;
+
+		float distance = player->distanceTo(*npc.go);
+		npc.showIcon = distance <= INTERACTION_RANGE;
+		std::cout << "[DS_Update] NPC '" << std::string(npc.go->name) << "' (RouteEnabled): Dist to Player=" << distance
+							<< ", NewShowIcon: " << npc.showIcon << std::endl;
+		return true;
+	});
 }
 
 void DialogSystem::render(Scene const& scene)
@@ -2,11 +2,14 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <functional> // For std::function (if GameObject.hpp uses it)
 
 #include <glm/glm.hpp>
 
+#include "AnimationTypes.hpp"
+
 // Forward declarations
 class GameObject; // Assumed to be defined in GameObject.hpp
 class Scene;      // Assumed to be defined in Scene.hpp
@@ -50,6 +53,7 @@ struct NPC {
 	bool isPlayingIdleAnimation{false};
 	float idleAnimationTime{0.0f};
 	int idleAnimationIndex{-1};
+	AnimationCursor idleAnimationCursor;
 };
 
 // DialogSystem Class Declaration
@@ -62,6 +66,8 @@ public:
 	void update(Scene& scene, float dt);
 	void render(Scene const& scene);
 	void processInput(GLFWwindow* window);
+	// Drop the NPCs and the game objects they hold, before the GL context goes away
+	void cleanup();
 
     // MOVED or ensured to be public
     int findIdleAnimationIndex(std::shared_ptr<GameObject> const& go);
@@ -84,6 +90,7 @@ private:
 	// int findIdleAnimationIndex(std::shared_ptr<GameObject> const& go); // Removed from private if it was here
 
 	std::vector<NPC> npcs_;
+	std::unordered_map<GameObject const*, std::size_t> npcIndex_; // npcs_ index of each NPC GameObject, for the proximity query hits
 };
 
 // To make the inline init functions compile within this header,
@@ -14,6 +14,9 @@ namespace BBoxUtil {
 BoundingBox getMeshBBox(Mesh const& mesh);
 glm::vec3 getBBoxCenter(BoundingBox const&);
 void updateLocalBBox(Model& m);
+void computeJointBindBBoxes(Model& m);
 bool isIntersectBBox(BoundingBox const& a, BoundingBox const& b);
 BoundingBox mergeBBox(BoundingBox const& a, BoundingBox const& b);
+bool containsBBox(BoundingBox const& outer, BoundingBox const& inner);
+float getBBoxSurfaceArea(BoundingBox const& bb);
 } // namespace BBoxUtil
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BoundingBox.hpp"
+
+class GameObject;
+
+/**
+ * @brief Dynamic bounding volume hierarchy of world space AABBs.
+ *
+ * Every leaf (proxy) stores a fattened copy of the object box, so an object moving a little stays inside
+ * its leaf and the tree is left untouched. Only when the box leaves its fat box the leaf is removed and
+ * inserted again, the ancestors are refitted and rebalanced with tree rotations on the way up.
+ * Nodes live in one vector and are referenced by index, freed nodes are recycled through a free list.
+ */
+class DynamicAABBTree {
+public:
+	static constexpr int k_nullNode = -1;
+
+	// Margin added on each side of a leaf box, and how far ahead along the displacement a leaf is extended
+	static constexpr float k_fatMargin = 0.1f;
+	static constexpr float k_displacementMultiplier = 2.0f;
+
+	// Proxy management, the returned id stays valid until destroyProxy
+	int createProxy(BoundingBox const& box, GameObject* userData);
+	void destroyProxy(int proxyId);
+	// Returns true when the proxy had to be reinserted
+	bool moveProxy(int proxyId, BoundingBox const& box, glm::vec3 const& displacement);
+	void clear();
+
+	GameObject* getUserData(int proxyId) const { return nodes_[proxyId].userData; }
+	BoundingBox const& getFatBBox(int proxyId) const { return nodes_[proxyId].box; }
+
+	// Tree info
+	bool empty() const { return root_ == k_nullNode; }
+	BoundingBox const& getRootBBox() const { return nodes_[root_].box; }
+	int getHeight() const { return root_ == k_nullNode ? 0 : nodes_[root_].height; }
+	int getProxyCount() const { return proxyCount_; }
+
+	/**
+	 * @brief Visit the proxies of every leaf whose box passes nodeTest, subtrees failing it are skipped.
+	 * @param nodeTest bool(BoundingBox const&) called on internal nodes and leaves
+	 * @param leafFn bool(int proxyId), return false to stop the traversal
+	 */
+	template <typename NodeTest, typename LeafFn>
+	void traverse(NodeTest&& nodeTest, LeafFn&& leafFn) const;
+
+	// Visit the proxies whose fat box overlaps the given box, leafFn has the same signature as in traverse
+	template <typename LeafFn>
+	void query(BoundingBox const& box, LeafFn&& leafFn) const
+	{
+		traverse([&box](BoundingBox const& nodeBox) { return BBoxUtil::isIntersectBBox(nodeBox, box); }, leafFn);
+	}
+
+private:
+	struct TreeNode {
+		BoundingBox box;
+		GameObject* userData{nullptr};
+		int parent{k_nullNode}; // Next free node while the node is in the free list
+		int child1{k_nullNode};
+		int child2{k_nullNode};
+		int height{-1}; // 0 for leaves, -1 for free nodes
+
+		bool isLeaf() const { return child1 == k_nullNode; }
+	};
+
+	std::vector<TreeNode> nodes_;
+	int root_{k_nullNode};
+	int freeList_{k_nullNode};
+	int proxyCount_{0};
+
+	int allocateNode_();
+	void freeNode_(int nodeId);
+	void insertLeaf_(int leaf);
+	void removeLeaf_(int leaf);
+	int balance_(int nodeId);
+	void refitAncestors_(int nodeId);
+};
+
+template <typename NodeTest, typename LeafFn>
+void DynamicAABBTree::traverse(NodeTest&& nodeTest, LeafFn&& leafFn) const
+{
+	if (root_ == k_nullNode)
+		return;
+
+	std::vector<int> stack;
+	stack.reserve(64);
+	stack.push_back(root_);
+
+	while (!stack.empty()) {
+		int nodeId = stack.back();
+		stack.pop_back();
+
+		TreeNode const& node = nodes_[nodeId];
+		if (!nodeTest(node.box))
+			continue;
+
+		if (node.isLeaf()) {
+			if (!leafFn(nodeId))
+				return;
+		}
+		else {
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+}
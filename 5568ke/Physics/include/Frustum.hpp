@@ -0,0 +1,22 @@
+#pragma once
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+#include "BoundingBox.hpp"
+
+/**
+ * @brief View frustum as six inward facing planes (xyz = normal, w = distance), a point p is inside a plane when dot(xyz, p) + w >= 0.
+ */
+struct Frustum {
+	enum Plane { PLANE_LEFT = 0, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+	std::array<glm::vec4, PLANE_COUNT> planes;
+};
+
+namespace FrustumUtil {
+// Gribb-Hartmann plane extraction from a projection * view matrix, the planes are normalized
+Frustum extractFrustum(glm::mat4 const& viewProjection);
+// Conservative test, false only when the box lies completely outside one of the planes
+bool isBBoxInFrustum(Frustum const& frustum, BoundingBox const& box);
+} // namespace FrustumUtil
@@ -2,12 +2,16 @@
 
 #include "BoundingBox.hpp"
 
+#include <glm/gtx/dual_quaternion.hpp>
+
 #include "Mesh.hpp"
 #include "Model.hpp"
 #include "Node.hpp"
 
 namespace BBoxUtil {
 namespace {
+constexpr float k_dualQuatBoundsMargin = 0.3f;
+
 BoundingBox transformBBox(BoundingBox const& in, glm::mat4 const& M)
 {
 	BoundingBox out;
@@ -24,13 +28,55 @@ BoundingBox transformBBox(BoundingBox const& in, glm::mat4 const& M)
 	return out;
 }
 
+glm::dualquat toDualQuat(glm::mat2x4 const& packed)
+{
+	return glm::dualquat(glm::quat(packed[0].w, packed[0].x, packed[0].y, packed[0].z), glm::quat(packed[1].w, packed[1].x, packed[1].y, packed[1].z));
+}
+
+// Same blend as skinned_dqs.vert
+glm::vec3 getDualQuatSkinnedPosition(Vertex const& v, Model const& model)
+{
+	glm::dualquat blended(glm::quat(0.0f, 0.0f, 0.0f, 0.0f), glm::quat(0.0f, 0.0f, 0.0f, 0.0f));
+	glm::quat pivot(0.0f, 0.0f, 0.0f, 0.0f);
+	bool hasPivot = false;
+
+	for (int i = 0; i < 4; ++i) {
+		float w = v.boneWeights[i];
+		int id = v.boneIds[i];
+		if (w <= 0.0f || id < 0 || static_cast<std::size_t>(id) >= model.jointDualQuaternions.size())
+			continue;
+
+		// q and -q are the same rotation, blend every joint in the hemisphere of the first one
+		glm::dualquat dq = toDualQuat(model.jointDualQuaternions[id]);
+		if (!hasPivot) {
+			pivot = dq.real;
+			hasPivot = true;
+		}
+		if (glm::dot(pivot, dq.real) < 0.0f)
+			w = -w;
+		blended = blended + dq * w;
+	}
+
+	if (!hasPivot || glm::length(blended.real) < 1e-6f)
+		return v.position;
+	return glm::normalize(blended) * v.position;
+}
+
 BoundingBox getSkinnedMeshBBox(Mesh const& mesh, Model const& model)
 {
 	BoundingBox bbox;
 	bbox.min = glm::vec3(std::numeric_limits<float>::max());
 	bbox.max = glm::vec3(std::numeric_limits<float>::lowest());
 
+	bool dualQuat = !model.jointDualQuaternions.empty();
 	for (auto const& v : mesh.vertices) {
+		if (dualQuat) {
+			glm::vec3 p = getDualQuatSkinnedPosition(v, model);
+			bbox.min = glm::min(bbox.min, p);
+			bbox.max = glm::max(bbox.max, p);
+			continue;
+		}
+
 		glm::vec4 pos(v.position, 1.0f);
 		glm::vec4 skinned(0.0f);
 		float total = 0.0f;
@@ -57,15 +103,50 @@ BoundingBox getSkinnedMeshBBox(Mesh const& mesh, Model const& model)
 	return bbox;
 }
 
+// Every skinned vertex is a weighted average of the vertex moved by each of its joints, so it lies inside the union of the joint boxes moved by their matrix
+BoundingBox getSkinnedModelBBox(Model const& model)
+{
+	BoundingBox bbox;
+	bbox.min = glm::vec3(std::numeric_limits<float>::max());
+	bbox.max = glm::vec3(std::numeric_limits<float>::lowest());
+
+	// A dual quaternion blend moves a vertex along an arc instead of the chord between its joint positions, so it can
+	// leave the joint boxes where the joints bend, by up to 1 - cos(45) of its distance to the joint for a 90 degree bend
+	bool dualQuat = !model.jointDualQuaternions.empty();
+
+	std::size_t jointCount = std::min(model.asset->jointBindBBoxes.size(), model.jointMatrices.size());
+	for (std::size_t j = 0; j < jointCount; ++j) {
+		BoundingBox const& bind = model.asset->jointBindBBoxes[j];
+		if (bind.min.x > bind.max.x)
+			continue;
+
+		BoundingBox moved = transformBBox(bind, model.jointMatrices[j]);
+		if (dualQuat) {
+			glm::vec3 margin = (moved.max - moved.min) * k_dualQuatBoundsMargin;
+			moved.min -= margin;
+			moved.max += margin;
+		}
+		bbox.min = glm::min(bbox.min, moved.min);
+		bbox.max = glm::max(bbox.max, moved.max);
+	}
+
+	if (model.asset->unskinnedBindBBox.min.x <= model.asset->unskinnedBindBBox.max.x) {
+		bbox.min = glm::min(bbox.min, model.asset->unskinnedBindBBox.min);
+		bbox.max = glm::max(bbox.max, model.asset->unskinnedBindBBox.max);
+	}
+
+	return bbox;
+}
+
 BoundingBox getStaticMeshBox(Model const& model, size_t meshIndex)
 {
-	BoundingBox local = model.boundingBoxes[meshIndex];
+	BoundingBox local = model.asset->boundingBoxes[meshIndex];
 	glm::mat4 nodeM(1.0f);
 
-	if (meshIndex < model.meshNodeIndices.size()) {
-		int nodeIdx = model.meshNodeIndices[meshIndex];
-		if (nodeIdx >= 0 && static_cast<std::size_t>(nodeIdx) < model.nodes.size() && model.nodes[nodeIdx])
-			nodeM = model.nodes[nodeIdx]->getNodeMatrix();
+	if (meshIndex < model.asset->meshNodeIndices.size()) {
+		int nodeIdx = model.asset->meshNodeIndices[meshIndex];
+		if (nodeIdx >= 0 && static_cast<std::size_t>(nodeIdx) < model.globalMatrices.size())
+			nodeM = model.getNodeMatrix(nodeIdx);
 	}
 
 	return transformBBox(local, nodeM);
@@ -109,11 +190,17 @@ void updateLocalBBox(Model& model)
 	// Applying the node matrix again would result in an oversized bounding box. Detect this case and avoid applying the extra transform.
 	bool hasSkinning = !model.jointMatrices.empty();
 
-	for (size_t i = 0; i < model.meshes.size(); ++i) {
+	// O(joints) path, available once computeJointBindBBoxes ran
+	if (hasSkinning && !model.asset->jointBindBBoxes.empty()) {
+		model.localSpaceBBox = getSkinnedModelBBox(model);
+		return;
+	}
+
+	for (size_t i = 0; i < model.asset->meshes.size(); ++i) {
 		BoundingBox local;
 
 		if (hasSkinning)
-			local = getSkinnedMeshBBox(model.meshes[i], model);
+			local = getSkinnedMeshBBox(model.asset->meshes[i], model);
 		else
 			local = getStaticMeshBox(model, i);
 
@@ -124,6 +211,40 @@ void updateLocalBBox(Model& model)
 	model.localSpaceBBox = global;
 }
 
+void computeJointBindBBoxes(Model& model)
+{
+	BoundingBox empty;
+	empty.min = glm::vec3(std::numeric_limits<float>::max());
+	empty.max = glm::vec3(std::numeric_limits<float>::lowest());
+
+	model.asset->jointBindBBoxes.assign(model.jointMatrices.size(), empty);
+	model.asset->unskinnedBindBBox = empty;
+
+	for (auto const& mesh : model.asset->meshes) {
+		for (auto const& v : mesh.vertices) {
+			bool isSkinned = false;
+
+			// A vertex counts for every joint it is weighted to
+			for (int i = 0; i < 4; ++i) {
+				float w = v.boneWeights[i];
+				int id = v.boneIds[i];
+
+				if (w > 0.0f && id >= 0 && static_cast<std::size_t>(id) < model.asset->jointBindBBoxes.size()) {
+					BoundingBox& box = model.asset->jointBindBBoxes[id];
+					box.min = glm::min(box.min, v.position);
+					box.max = glm::max(box.max, v.position);
+					isSkinned = true;
+				}
+			}
+
+			if (!isSkinned) {
+				model.asset->unskinnedBindBBox.min = glm::min(model.asset->unskinnedBindBBox.min, v.position);
+				model.asset->unskinnedBindBBox.max = glm::max(model.asset->unskinnedBindBBox.max, v.position);
+			}
+		}
+	}
+}
+
 // Fast overlap test (inclusive)
 bool isIntersectBBox(BoundingBox const& a, BoundingBox const& b)
 {
@@ -132,4 +253,17 @@ bool isIntersectBBox(BoundingBox const& a, BoundingBox const& b)
 
 // Combine two boxes (useful for hierarchy/BVH later)
 BoundingBox mergeBBox(BoundingBox const& a, BoundingBox const& b) { return {glm::min(a.min, b.min), glm::max(a.max, b.max)}; }
+
+bool containsBBox(BoundingBox const& outer, BoundingBox const& inner)
+{
+	return (outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z) &&
+				 (inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z);
+}
+
+// Used as the insertion cost of the BVH, a ray/frustum hits a box proportionally to its surface area
+float getBBoxSurfaceArea(BoundingBox const& bb)
+{
+	glm::vec3 d = bb.max - bb.min;
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
 } // namespace BBoxUtil
@@ -0,0 +1,272 @@
+#include "CollisionSystem.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+void CollisionSystem::add(std::shared_ptr<AABBCollider> c)
+{
+	if (!c || !c->owner())
+		return;
+
+	colliders_.push_back(c);
+
+	if (c->owner()->invMass <= 0.0f) {
+		staticProxies_.push_back({c.get(), c->bounds()});
+		staticDirty_ = true;
+	}
+	else {
+		// Appended at the end, the next insertion sort moves it to its place
+		dynamicProxies_.push_back({c.get(), c->bounds()});
+	}
+}
+
+void CollisionSystem::remove(std::shared_ptr<AABBCollider> c)
+{
+	auto isSame = [&](Proxy const& p) { return p.collider == c.get(); };
+
+	std::size_t staticCount = staticProxies_.size();
+	staticProxies_.erase(std::remove_if(staticProxies_.begin(), staticProxies_.end(), isSame), staticProxies_.end());
+	if (staticProxies_.size() != staticCount)
+		staticDirty_ = true;
+
+	dynamicProxies_.erase(std::remove_if(dynamicProxies_.begin(), dynamicProxies_.end(), isSame), dynamicProxies_.end());
+	colliders_.erase(std::remove(colliders_.begin(), colliders_.end(), c), colliders_.end());
+}
+
+void CollisionSystem::cleanup()
+{
+	colliders_.clear();
+	dynamicProxies_.clear();
+	staticProxies_.clear();
+	for (auto& order : staticOrder_)
+		order.clear();
+	activeStatics_.clear();
+	candidatePairs_.clear();
+	staticDirty_ = false;
+}
+
+void CollisionSystem::update()
+{
+	if (staticDirty_)
+		rebuildStatics_();
+
+	// Refresh the bounds snapshot and pick the axis along which the dynamic colliders are spread the most
+	glm::vec3 sum(0.0f);
+	glm::vec3 sumSq(0.0f);
+	for (auto& proxy : dynamicProxies_) {
+		proxy.box = proxy.collider->bounds();
+
+		glm::vec3 center = BBoxUtil::getBBoxCenter(proxy.box);
+		sum += center;
+		sumSq += center * center;
+	}
+
+	int axis = sweepAxis_;
+	if (!dynamicProxies_.empty()) {
+		float invCount = 1.0f / static_cast<float>(dynamicProxies_.size());
+		glm::vec3 variance = sumSq * invCount - (sum * invCount) * (sum * invCount);
+		axis = 0;
+		if (variance.y > variance[axis])
+			axis = 1;
+		if (variance.z > variance[axis])
+			axis = 2;
+	}
+
+	sortDynamics_(axis, axis != sweepAxis_);
+	sweepAxis_ = axis;
+
+	candidatePairs_.clear();
+	findDynamicPairs_();
+	findStaticPairs_();
+
+	stats_.dynamicColliders = dynamicProxies_.size();
+	stats_.staticColliders = staticProxies_.size();
+	stats_.candidatePairs = candidatePairs_.size();
+	stats_.sweepAxis = sweepAxis_;
+	stats_.contacts = 0;
+
+	// Narrow phase, the bounds are read again since resolving a pair may move its objects
+	for (auto const& [a, b] : candidatePairs_) {
+		if (BBoxUtil::isIntersectBBox(a->bounds(), b->bounds())) {
+			onCollision_(a->owner(), b->owner());
+			stats_.contacts++;
+		}
+	}
+}
+
+void CollisionSystem::rebuildStatics_()
+{
+	for (auto& proxy : staticProxies_)
+		proxy.box = proxy.collider->bounds();
+
+	for (int axis = 0; axis < 3; ++axis) {
+		auto& order = staticOrder_[axis];
+		order.resize(staticProxies_.size());
+		std::iota(order.begin(), order.end(), std::size_t{0});
+		std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return staticProxies_[a].box.min[axis] < staticProxies_[b].box.min[axis]; });
+	}
+
+	staticDirty_ = false;
+}
+
+void CollisionSystem::sortDynamics_(int axis, bool axisChanged)
+{
+	auto less = [axis](Proxy const& a, Proxy const& b) { return a.box.min[axis] < b.box.min[axis]; };
+
+	if (axisChanged) {
+		std::sort(dynamicProxies_.begin(), dynamicProxies_.end(), less);
+		return;
+	}
+
+	// Objects move little between frames, so the previous order is almost sorted and insertion sort is close to O(n)
+	for (std::size_t i = 1; i < dynamicProxies_.size(); ++i) {
+		Proxy proxy = dynamicProxies_[i];
+		std::size_t j = i;
+		while (j > 0 && less(proxy, dynamicProxies_[j - 1])) {
+			dynamicProxies_[j] = dynamicProxies_[j - 1];
+			--j;
+		}
+		dynamicProxies_[j] = proxy;
+	}
+}
+
+void CollisionSystem::findDynamicPairs_()
+{
+	int const axis = sweepAxis_;
+	std::size_t n = dynamicProxies_.size();
+
+	for (std::size_t i = 0; i < n; ++i) {
+		Proxy const& a = dynamicProxies_[i];
+
+		// Every following proxy starting after 'a' ends can't overlap it, nor can any proxy after that one
+		for (std::size_t j = i + 1; j < n && dynamicProxies_[j].box.min[axis] <= a.box.max[axis]; ++j) {
+			Proxy const& b = dynamicProxies_[j];
+			if (BBoxUtil::isIntersectBBox(a.box, b.box))
+				candidatePairs_.emplace_back(a.collider, b.collider);
+		}
+	}
+}
+
+void CollisionSystem::findStaticPairs_()
+{
+	int const axis = sweepAxis_;
+	auto const& order = staticOrder_[axis];
+
+	// Merge the sorted dynamic list with the sorted static list, 'activeStatics_' holds the statics whose interval is still open
+	activeStatics_.clear();
+	std::size_t cursor = 0;
+
+	for (Proxy const& d : dynamicProxies_) {
+		// Open the statics starting before this dynamic collider
+		while (cursor < order.size() && staticProxies_[order[cursor]].box.min[axis] <= d.box.min[axis]) {
+			activeStatics_.push_back(order[cursor]);
+			++cursor;
+		}
+
+		// Close the statics ending before it, the later dynamics start even further so they can't hit them either
+		std::erase_if(activeStatics_, [&](std::size_t s) { return staticProxies_[s].box.max[axis] < d.box.min[axis]; });
+
+		for (std::size_t s : activeStatics_) {
+			Proxy const& st = staticProxies_[s];
+			if (BBoxUtil::isIntersectBBox(d.box, st.box))
+				candidatePairs_.emplace_back(d.collider, st.collider);
+		}
+
+		// Statics starting inside the dynamic interval
+		for (std::size_t k = cursor; k < order.size() && staticProxies_[order[k]].box.min[axis] <= d.box.max[axis]; ++k) {
+			Proxy const& st = staticProxies_[order[k]];
+			if (BBoxUtil::isIntersectBBox(d.box, st.box))
+				candidatePairs_.emplace_back(d.collider, st.collider);
+		}
+	}
+}
+
+void CollisionSystem::onCollision_(std::shared_ptr<GameObject> a, std::shared_ptr<GameObject> b)
+{
+	auto& A = *a;
+	auto& B = *b;
+
+	// Compute AABB overlap on each axis
+	auto const& aMin = A.worldBBox.min;
+	auto const& aMax = A.worldBBox.max;
+	auto const& bMin = B.worldBBox.min;
+	auto const& bMax = B.worldBBox.max;
+
+	float overlapX = std::min(aMax.x - bMin.x, bMax.x - aMin.x);
+	float overlapY = std::min(aMax.y - bMin.y, bMax.y - aMin.y);
+	float overlapZ = std::min(aMax.z - bMin.z, bMax.z - aMin.z);
+
+	// Find smallest penetration axis & its unit normal
+	float penetration = std::min({overlapX, overlapY, overlapZ});
+	glm::vec3 axisNormal;
+	enum { AX_X, AX_Y, AX_Z } axis;
+	if (penetration == overlapX) {
+		axis = AX_X;
+		axisNormal = {1, 0, 0};
+	}
+	else if (penetration == overlapY) {
+		axis = AX_Y;
+		axisNormal = {0, 1, 0};
+	}
+	else {
+		axis = AX_Z;
+		axisNormal = {0, 0, 1};
+	}
+
+	// Compute centers to know which side to push
+	glm::vec3 centerA = BBoxUtil::getBBoxCenter(A.worldBBox);
+	glm::vec3 centerB = BBoxUtil::getBBoxCenter(B.worldBBox);
+	float side = (glm::dot(centerB - centerA, axisNormal) >= 0.0f ? 1.0f : -1.0f);
+	glm::vec3 pushDir = axisNormal * side; // direction to push A out of B
+
+	float invMassSum = A.invMass + B.invMass;
+	if (invMassSum <= 0.0f) {
+		// both static -> nothing to do
+		return;
+	}
+
+	// Vertical contact hack: if Y-axis collision, full correction + zero Y-velocity
+	if (axis == AX_Y) {
+		// push A and B fully out of overlap along Y
+		float corrA = (penetration * (A.invMass / invMassSum));
+		float corrB = (penetration * (B.invMass / invMassSum));
+		A.position -= pushDir * corrA;
+		B.position += pushDir * corrB;
+
+		// zero vertical velocities so they rest
+		if (A.invMass > 0)
+			A.velocity.y = 0.0f;
+		if (B.invMass > 0)
+			B.velocity.y = 0.0f;
+	}
+	else {
+		// Fractional correction for non-vertical collisions (prevents jitter)
+		float const k_slop = 0.01f; // small penetration allowance
+		float const percent = 0.4f; // correct 40% per frame
+		float correctionMag = std::max(penetration - k_slop, 0.0f) / invMassSum * percent;
+		glm::vec3 correction = pushDir * correctionMag;
+		A.position -= correction * A.invMass;
+		B.position += correction * B.invMass;
+
+		// Recompute transforms before impulse
+		A.updateTransformMatrix();
+		B.updateTransformMatrix();
+
+		// Apply bounce impulse only if moving into each other
+		glm::vec3 relVel = A.velocity - B.velocity;
+		float vn = glm::dot(relVel, pushDir);
+		if (vn < 0.0f) {
+			float e = std::min(A.restitution, B.restitution);
+			float j = -(1 + e) * vn / invMassSum;
+			glm::vec3 impulse = pushDir * j;
+			A.velocity += impulse * A.invMass;
+			B.velocity -= impulse * B.invMass;
+		}
+	}
+
+	// Final transforms & user callbacks
+	A.updateTransformMatrix();
+	B.updateTransformMatrix();
+	a->onCollisionEnter(b);
+	b->onCollisionEnter(a);
+}
@@ -0,0 +1,302 @@
+#include "DynamicAABBTree.hpp"
+
+#include <algorithm>
+
+namespace {
+BoundingBox fattenBBox(BoundingBox const& box, glm::vec3 const& displacement)
+{
+	BoundingBox fat{box.min - glm::vec3(DynamicAABBTree::k_fatMargin), box.max + glm::vec3(DynamicAABBTree::k_fatMargin)};
+
+	// Extend the box towards where the object is heading
+	glm::vec3 d = displacement * DynamicAABBTree::k_displacementMultiplier;
+	fat.min = glm::min(fat.min, fat.min + d);
+	fat.max = glm::max(fat.max, fat.max + d);
+	return fat;
+}
+} // namespace
+
+int DynamicAABBTree::createProxy(BoundingBox const& box, GameObject* userData)
+{
+	int proxyId = allocateNode_();
+	nodes_[proxyId].box = fattenBBox(box, glm::vec3(0.0f));
+	nodes_[proxyId].userData = userData;
+	nodes_[proxyId].height = 0;
+
+	insertLeaf_(proxyId);
+	++proxyCount_;
+	return proxyId;
+}
+
+void DynamicAABBTree::destroyProxy(int proxyId)
+{
+	removeLeaf_(proxyId);
+	freeNode_(proxyId);
+	--proxyCount_;
+}
+
+bool DynamicAABBTree::moveProxy(int proxyId, BoundingBox const& box, glm::vec3 const& displacement)
+{
+	BoundingBox const& current = nodes_[proxyId].box;
+	BoundingBox fat = fattenBBox(box, displacement);
+
+	// Still inside its leaf, unless the leaf grew much larger than needed (e.g. after a teleport followed by a stop)
+	if (BBoxUtil::containsBBox(current, box)) {
+		BoundingBox huge{fat.min - glm::vec3(4.0f * k_fatMargin), fat.max + glm::vec3(4.0f * k_fatMargin)};
+		if (BBoxUtil::containsBBox(huge, current))
+			return false;
+	}
+
+	removeLeaf_(proxyId);
+	nodes_[proxyId].box = fat;
+	insertLeaf_(proxyId);
+	return true;
+}
+
+void DynamicAABBTree::clear()
+{
+	nodes_.clear();
+	root_ = k_nullNode;
+	freeList_ = k_nullNode;
+	proxyCount_ = 0;
+}
+
+int DynamicAABBTree::allocateNode_()
+{
+	if (freeList_ == k_nullNode) {
+		nodes_.emplace_back();
+		return static_cast<int>(nodes_.size()) - 1;
+	}
+
+	int nodeId = freeList_;
+	freeList_ = nodes_[nodeId].parent;
+	nodes_[nodeId] = TreeNode{};
+	return nodeId;
+}
+
+void DynamicAABBTree::freeNode_(int nodeId)
+{
+	nodes_[nodeId] = TreeNode{};
+	nodes_[nodeId].parent = freeList_;
+	freeList_ = nodeId;
+}
+
+void DynamicAABBTree::insertLeaf_(int leaf)
+{
+	if (root_ == k_nullNode) {
+		root_ = leaf;
+		nodes_[leaf].parent = k_nullNode;
+		return;
+	}
+
+	// Walk down to the best sibling, choosing the child with the smallest surface area increase
+	BoundingBox leafBox = nodes_[leaf].box;
+	int index = root_;
+	while (!nodes_[index].isLeaf()) {
+		TreeNode const& node = nodes_[index];
+		int child1 = node.child1;
+		int child2 = node.child2;
+
+		float area = BBoxUtil::getBBoxSurfaceArea(node.box);
+		float combinedArea = BBoxUtil::getBBoxSurfaceArea(BBoxUtil::mergeBBox(node.box, leafBox));
+
+		// Cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		auto descendCost = [&](int child) {
+			TreeNode const& c = nodes_[child];
+			float mergedArea = BBoxUtil::getBBoxSurfaceArea(BBoxUtil::mergeBBox(leafBox, c.box));
+			if (c.isLeaf())
+				return mergedArea + inheritanceCost;
+			return (mergedArea - BBoxUtil::getBBoxSurfaceArea(c.box)) + inheritanceCost;
+		};
+		float cost1 = descendCost(child1);
+		float cost2 = descendCost(child2);
+
+		if (cost < cost1 && cost < cost2)
+			break;
+
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	int sibling = index;
+
+	// Create a new parent holding the sibling and the leaf
+	int oldParent = nodes_[sibling].parent;
+	int newParent = allocateNode_();
+	nodes_[newParent].parent = oldParent;
+	nodes_[newParent].box = BBoxUtil::mergeBBox(leafBox, nodes_[sibling].box);
+	nodes_[newParent].height = nodes_[sibling].height + 1;
+	nodes_[newParent].child1 = sibling;
+	nodes_[newParent].child2 = leaf;
+	nodes_[sibling].parent = newParent;
+	nodes_[leaf].parent = newParent;
+
+	if (oldParent != k_nullNode) {
+		if (nodes_[oldParent].child1 == sibling)
+			nodes_[oldParent].child1 = newParent;
+		else
+			nodes_[oldParent].child2 = newParent;
+	}
+	else {
+		root_ = newParent;
+	}
+
+	refitAncestors_(nodes_[leaf].parent);
+}
+
+void DynamicAABBTree::removeLeaf_(int leaf)
+{
+	if (leaf == root_) {
+		root_ = k_nullNode;
+		return;
+	}
+
+	int parent = nodes_[leaf].parent;
+	int grandParent = nodes_[parent].parent;
+	int sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+
+	if (grandParent != k_nullNode) {
+		// Replace the parent with the sibling
+		if (nodes_[grandParent].child1 == parent)
+			nodes_[grandParent].child1 = sibling;
+		else
+			nodes_[grandParent].child2 = sibling;
+		nodes_[sibling].parent = grandParent;
+		freeNode_(parent);
+
+		refitAncestors_(grandParent);
+	}
+	else {
+		root_ = sibling;
+		nodes_[sibling].parent = k_nullNode;
+		freeNode_(parent);
+	}
+}
+
+void DynamicAABBTree::refitAncestors_(int nodeId)
+{
+	while (nodeId != k_nullNode) {
+		nodeId = balance_(nodeId);
+
+		TreeNode& node = nodes_[nodeId];
+		TreeNode const& child1 = nodes_[node.child1];
+		TreeNode const& child2 = nodes_[node.child2];
+
+		node.height = 1 + std::max(child1.height, child2.height);
+		node.box = BBoxUtil::mergeBBox(child1.box, child2.box);
+
+		nodeId = node.parent;
+	}
+}
+
+// Perform a left or right rotation if node A is imbalanced, returns the new root of the subtree
+int DynamicAABBTree::balance_(int iA)
+{
+	TreeNode& A = nodes_[iA];
+	if (A.isLeaf() || A.height < 2)
+		return iA;
+
+	int iB = A.child1;
+	int iC = A.child2;
+	TreeNode& B = nodes_[iB];
+	TreeNode& C = nodes_[iC];
+
+	int balance = C.height - B.height;
+
+	// Rotate C up
+	if (balance > 1) {
+		int iF = C.child1;
+		int iG = C.child2;
+		TreeNode& F = nodes_[iF];
+		TreeNode& G = nodes_[iG];
+
+		// Swap A and C
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+
+		// A's old parent should point to C
+		if (C.parent != k_nullNode) {
+			if (nodes_[C.parent].child1 == iA)
+				nodes_[C.parent].child1 = iC;
+			else
+				nodes_[C.parent].child2 = iC;
+		}
+		else {
+			root_ = iC;
+		}
+
+		// Keep the taller grandchild under C
+		if (F.height > G.height) {
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.box = BBoxUtil::mergeBBox(B.box, G.box);
+			C.box = BBoxUtil::mergeBBox(A.box, F.box);
+			A.height = 1 + std::max(B.height, G.height);
+			C.height = 1 + std::max(A.height, F.height);
+		}
+		else {
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.box = BBoxUtil::mergeBBox(B.box, F.box);
+			C.box = BBoxUtil::mergeBBox(A.box, G.box);
+			A.height = 1 + std::max(B.height, F.height);
+			C.height = 1 + std::max(A.height, G.height);
+		}
+
+		return iC;
+	}
+
+	// Rotate B up
+	if (balance < -1) {
+		int iD = B.child1;
+		int iE = B.child2;
+		TreeNode& D = nodes_[iD];
+		TreeNode& E = nodes_[iE];
+
+		// Swap A and B
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+
+		// A's old parent should point to B
+		if (B.parent != k_nullNode) {
+			if (nodes_[B.parent].child1 == iA)
+				nodes_[B.parent].child1 = iB;
+			else
+				nodes_[B.parent].child2 = iB;
+		}
+		else {
+			root_ = iB;
+		}
+
+		// Keep the taller grandchild under B
+		if (D.height > E.height) {
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.box = BBoxUtil::mergeBBox(C.box, E.box);
+			B.box = BBoxUtil::mergeBBox(A.box, D.box);
+			A.height = 1 + std::max(C.height, E.height);
+			B.height = 1 + std::max(A.height, D.height);
+		}
+		else {
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.box = BBoxUtil::mergeBBox(C.box, D.box);
+			B.box = BBoxUtil::mergeBBox(A.box, E.box);
+			A.height = 1 + std::max(C.height, D.height);
+			B.height = 1 + std::max(A.height, E.height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
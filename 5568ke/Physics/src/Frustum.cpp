@@ -0,0 +1,37 @@
+#include "Frustum.hpp"
+
+namespace FrustumUtil {
+Frustum extractFrustum(glm::mat4 const& m)
+{
+	// glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+	auto row = [&m](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+	glm::vec4 r0 = row(0);
+	glm::vec4 r1 = row(1);
+	glm::vec4 r2 = row(2);
+	glm::vec4 r3 = row(3);
+
+	Frustum frustum;
+	frustum.planes[Frustum::PLANE_LEFT] = r3 + r0;
+	frustum.planes[Frustum::PLANE_RIGHT] = r3 - r0;
+	frustum.planes[Frustum::PLANE_BOTTOM] = r3 + r1;
+	frustum.planes[Frustum::PLANE_TOP] = r3 - r1;
+	frustum.planes[Frustum::PLANE_NEAR] = r3 + r2;
+	frustum.planes[Frustum::PLANE_FAR] = r3 - r2;
+
+	for (auto& plane : frustum.planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	return frustum;
+}
+
+bool isBBoxInFrustum(Frustum const& frustum, BoundingBox const& box)
+{
+	for (auto const& plane : frustum.planes) {
+		// Corner of the box furthest along the plane normal, if it is outside the whole box is
+		glm::vec3 p{plane.x >= 0.0f ? box.max.x : box.min.x, plane.y >= 0.0f ? box.max.y : box.min.y, plane.z >= 0.0f ? box.max.z : box.min.z};
+		if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+} // namespace FrustumUtil
@@ -6,6 +6,7 @@
 
 #include <glm/glm.hpp>
 
+#include "Frustum.hpp"
 #include "include_5568ke.hpp"
 
 class Shader;
@@ -18,7 +19,7 @@ public:
 	static BoundingBoxVisualizer& getInstance();
 	void init();		// create VAO / VBO
 	void cleanup(); // destroy GL objects
-	void draw(Scene const& scene);
+	void draw(Scene const& scene, Frustum const& frustum); // Boxes outside the frustum are skipped
 
 	std::shared_ptr<Shader> boxShader;
 
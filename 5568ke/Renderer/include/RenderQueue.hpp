@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class Material;
+class Model;
+class Shader;
+
+/**
+ * @brief Per-frame list of primitive draws, sorted by a 64-bit key so draws sharing GL state end up adjacent.
+ *
+ * Key layout from the most significant bit: pass (2) | shader (10) | material (16) | VAO (16) | depth (20).
+ * Inside a run of the same shader, material and VAO the draws go front to back.
+ * submit() only touches the GL state that differs from the previous draw.
+ *
+ * Static draws of the same primitive (same VAO range and material) are gathered while the queue is filled.
+ * When a primitive is seen at least k_minInstances times and instancedShader is set, all its transforms go to one
+ * instance buffer and it is drawn with a single glDrawElementsInstanced.
+ *
+ * The joints of every skinned model queued this frame are packed into one palette buffer of RGBA32F texels, read
+ * through a samplerBuffer: four texels per matrix for skinned.vert, or two per dual quaternion for skinned_dqs.vert
+ * when the model has them. Each model is copied once however many primitives it has, and a draw only sends the
+ * texel offset of its model's range.
+ */
+class RenderQueue {
+public:
+	// Double-sided primitives get their own pass so GL_CULL_FACE is toggled at most once per frame
+	enum Pass : std::uint64_t { PASS_OPAQUE = 0, PASS_DOUBLE_SIDED = 1 };
+
+	// Distances beyond this share the last depth bucket
+	static constexpr float k_maxSortDepth = 500.0f;
+
+	// Fewest copies of a primitive drawn instanced, and the first attribute of the per-instance matrix (see blinn_instanced.vert)
+	static constexpr std::size_t k_minInstances = 2;
+	static constexpr unsigned int k_instanceMatrixLocation = 5;
+
+	// Texture unit of the joint palette, after the material units
+	static constexpr unsigned int k_jointPaletteUnit = 4;
+
+	struct DrawItem {
+		Shader const* shader;
+		Material const* material;
+		std::uint32_t jointOffset; // First texel of the model in the joint palette, skinned draws only
+		unsigned int vao;
+		unsigned int indexCount;
+		unsigned int indexOffset; // In indices
+		unsigned int indexType;		// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		bool doubleSided;
+		bool skinned;
+		bool unweighted; // Skinned shader on a mesh without bone weights, the weights come from the generic attribute
+		glm::mat4 transform;					 // Single draws only
+		std::uint32_t firstInstance{}; // Instanced draws, range in the instance buffer
+		std::uint32_t instanceCount{1};
+	};
+
+	struct Stats {
+		int drawCalls{};
+		int instancedDrawCalls{}; // Part of drawCalls
+		int instances{};					// Objects drawn by the instanced calls
+		int stateChanges{};
+		int stateChangesAvoided{}; // Binds skipped because the state was already current
+		int triangles{};					 // Submitted, instances included
+		int joints{};							 // In the joint palette
+		int jointBytes{};					 // Joint palette upload
+		int jointMatrixBytes{};		 // Same joints uploaded as matrices
+	};
+
+	// Shader used for instanced draws, nullptr draws every copy on its own
+	Shader const* instancedShader{nullptr};
+
+	void init();
+	void cleanup();
+
+	void clear();
+	// Queue every primitive of the model, depth is the distance to the camera.
+	// lod 0 is full detail, higher levels pick Primitive::lods, clamped to the levels each primitive has
+	void addModel(Model const& model, glm::mat4 const& modelMatrix, Shader const& shader, bool skinned, float depth, int lod = 0);
+	void sort();
+	Stats submit();
+
+	std::size_t size() const { return items_.size(); }
+
+private:
+	std::vector<DrawItem> items_;
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> order_; // (key, item index), sorted by key
+
+	// Static draws grouped by primitive until sort() turns them into items
+	struct BatchKey {
+		Shader const* shader;
+		Material const* material;
+		unsigned int vao;
+		unsigned int indexOffset;
+		unsigned int indexCount;
+		bool operator==(BatchKey const&) const = default;
+	};
+	struct BatchKeyHash {
+		std::size_t operator()(BatchKey const& k) const noexcept;
+	};
+	struct Batch {
+		DrawItem item;
+		float depth; // Nearest copy
+		std::vector<glm::mat4> transforms;
+	};
+	std::vector<Batch> batches_;
+	std::unordered_map<BatchKey, std::size_t, BatchKeyHash> batchIndex_;
+
+	// Per-instance model matrices of every instanced draw, uploaded once per frame
+	std::vector<glm::mat4> instanceMatrices_;
+	unsigned int instanceVbo_{};
+	std::size_t instanceVboCapacity_{}; // In matrices
+
+	// Joints of the skinned models, uploaded once per frame
+	std::vector<glm::vec4> jointPalette_;
+	std::unordered_map<Model const*, std::uint32_t> jointOffsets_;
+	int jointCount_{};
+	unsigned int jointBuffer_{};
+	unsigned int jointTexture_{};
+	std::size_t jointBufferCapacity_{}; // In texels
+	std::size_t maxJointTexels_{};			// GL_MAX_TEXTURE_BUFFER_SIZE
+
+	// Small ids handed out in the order objects are first seen this frame
+	std::unordered_map<void const*, std::uint64_t> shaderIds_;
+	std::unordered_map<void const*, std::uint64_t> materialIds_;
+	std::unordered_map<unsigned int, std::uint64_t> vaoIds_;
+
+	void pushItem_(DrawItem const& item, float depth);
+	std::uint64_t makeKey_(DrawItem const& item, float depth);
+	void uploadInstances_();
+	void uploadJointPalette_();
+	// Palette offset of the model, its joints are appended the first time it is seen this frame. False when the palette is full
+	bool addJoints_(Model const& model, std::uint32_t& offset);
+	void bindInstanceAttributes_(std::uint32_t firstInstance) const;
+};
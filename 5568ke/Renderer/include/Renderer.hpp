@@ -8,10 +8,13 @@
 #include <glm/vec3.hpp>
 
 #include "BoundingBoxVisualizer.hpp"
+#include "Frustum.hpp"
 #include "LightVisualizer.hpp"
+#include "RenderQueue.hpp"
 #include "SkeletonVisualizer.hpp"
 #include "SkyboxVisualizer.hpp"
 
+class GameObject;
 class Scene;
 class Shader;
 
@@ -25,9 +28,37 @@ public:
 	void endFrame();
 	void drawScene(Scene const& scene);
 
+	// Lights beyond this count are ignored, must match MAX_LIGHTS in the shaders
+	static constexpr int k_maxLights = 10;
+
+	// Stats of the frame being drawn, complete once drawScene returns
+	struct FrameStats {
+		int drawCalls{}; // One per primitive, or per instanced primitive
+		int instancedDrawCalls{};
+		int instances{}; // Primitive copies drawn by the instanced calls
+		int visibleEntities{};
+		int culledEntities{};			 // Visible flagged objects outside the view frustum
+		int stateChanges{};				 // Shader, material, VAO, joint palette and culling changes made by the render queue
+		int stateChangesAvoided{}; // The same, skipped because the state was already current
+		int redundantGLCallsSkipped{}; // Program, texture and sampler calls dropped by GLStateCache
+		int triangles{};							 // Submitted by the model draws
+		int joints{};									 // In the joint palette
+		int jointBytes{};							 // Joint palette upload
+		int jointMatrixBytes{};				 // Same joints uploaded as matrices
+		int lodEntities[4]{};					 // Entities drawn at each level of detail
+	};
+	FrameStats const& getFrameStats() const { return currentFrameStats_; }
+
 	// Flag to control main visualization
 	bool showModels{true};
 	bool showWireFrame{false};
+	bool useInstancing{true}; // Draw repeated static primitives with one instanced call
+
+	// Level of detail by projected size, an entity whose bounding sphere covers less than k_lodCoverage[i] of the half screen height
+	// is drawn at level i + 1. A larger lodBias switches to the coarser levels sooner
+	static constexpr float k_lodCoverage[] = {0.5f, 0.25f, 0.1f};
+	bool useLods{true};
+	float lodBias{1.0f};
 
 	// Flag to control call visualizer
 	bool showSkybox{true};
@@ -49,19 +80,26 @@ private:
 	std::unordered_map<std::string, std::shared_ptr<Shader>> shaders_;
 	std::shared_ptr<Shader> mainShader_;
 	std::shared_ptr<Shader> skinnedShader_;
+	std::shared_ptr<Shader> skinnedDqsShader_; // Models with Model::jointDualQuaternions
+	std::shared_ptr<Shader> instancedShader_;
+
+	// Per-frame camera and lighting data, bound once at Shader::k_frameDataBinding
+	unsigned int frameDataUbo_{};
+	unsigned int defaultTexture_{}; // White 1x1 fallback, see BlinnPhongMaterial::fallbackTexture
+
+	// View frustum of the current frame and the objects found inside it, reused every frame
+	Frustum frustum_{};
+	std::vector<GameObject*> visibleObjects_;
+	RenderQueue renderQueue_;
 
 	// Helper methods for different rendering passes
+	void updateFrameData_(Scene const& scene);
 	void drawModels_(Scene const& scene);
-	void setupLighting_(Scene const& scene, std::shared_ptr<Shader> const& shader);
 
 	// Renderer state
 	int viewportWidth_{};
 	int viewportHeight_{};
 
 	// Current frame stats
-	struct FrameStats {
-		int drawCalls{};
-		int visibleEntities{};
-	};
 	FrameStats currentFrameStats_;
 };
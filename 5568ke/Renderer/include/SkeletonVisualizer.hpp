@@ -24,7 +24,7 @@ public:
 
 	bool hasSkeletonData(std::shared_ptr<Model> model) const;
 	void generateSkeletonData(std::shared_ptr<Model> model);
-	void draw(GameObject const& gameObject, Camera const& cam); // Draw simple debug lines with axes, grid, etc.
+	void draw(GameObject const& gameObject); // Draw simple debug lines with axes, grid, etc.
 
 	std::shared_ptr<Shader> skeletonShader;
 
@@ -33,7 +33,8 @@ private:
 	~SkeletonVisualizer() = default;
 
 	// Helper methods for visualization
-	void processNodeTreePositionsRecursive(std::shared_ptr<Node> node, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& colors, float nodePosScale);
+	void processNodeTreePositionsRecursive(Model const& model, std::shared_ptr<Node> node, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& colors,
+																						 float nodePosScale);
 	void addDotJoint(glm::vec3 const& position, float radius, glm::vec3 const& color, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& colors);
 
 	// OpenGL resources
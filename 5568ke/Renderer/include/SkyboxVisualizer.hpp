@@ -17,7 +17,7 @@ public:
 	static SkyboxVisualizer& getInstance();
 	void init();
 	void cleanup();
-	void draw(Scene const& scene); // The of skybox should be done first, with depth test configured
+	void draw(); // The of skybox should be done first, with depth test configured
 
 	// Load skybox from gltf file (or directory of 6 images for traditional cubemap)
 	bool loadSkyboxFromGltf(std::string const& gltfPath);
@@ -68,7 +68,7 @@ static void buildBoxLines(glm::vec3 const& min, glm::vec3 const& max, std::vecto
 	push(v010, v110); // connect
 }
 
-void BoundingBoxVisualizer::draw(Scene const& scene)
+void BoundingBoxVisualizer::draw(Scene const& scene, Frustum const& frustum)
 {
 	if (!boxShader)
 		return;
@@ -77,7 +77,7 @@ void BoundingBoxVisualizer::draw(Scene const& scene)
 	verts.reserve(scene.gameObjects.size() * 24);
 
 	for (auto const& goPtr : scene.gameObjects) {
-		if (!goPtr->visible || !goPtr->getModel())
+		if (!goPtr->visible || !goPtr->isInFrustum(frustum))
 			continue;
 
 		auto const& bb = goPtr->worldBBox;
@@ -94,8 +94,6 @@ void BoundingBoxVisualizer::draw(Scene const& scene)
 
 	// simple colour – bright magenta
 	boxShader->bind();
-	boxShader->sendMat4("view", scene.cam.view);
-	boxShader->sendMat4("proj", scene.cam.proj);
 	boxShader->sendMat4("model", glm::mat4(1.0f));
 	boxShader->sendVec3("uColor", glm::vec3(1, 1, 1));
 
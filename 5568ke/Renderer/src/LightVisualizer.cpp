@@ -48,8 +48,6 @@ void LightPointVisualizer::draw(Scene const& scene)
 	glBufferData(GL_ARRAY_BUFFER, pts.size() * sizeof(glm::vec3), pts.data(), GL_DYNAMIC_DRAW);
 
 	lightPointShader->bind();
-	lightPointShader->sendMat4("view", scene.cam.view);
-	lightPointShader->sendMat4("proj", scene.cam.proj);
 	lightPointShader->sendFloat("pointSize", 50.0f); // see lightPointShader below
 
 	// disable depth just like skeleton (so gizmos are always visible)
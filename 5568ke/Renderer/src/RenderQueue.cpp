@@ -0,0 +1,344 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <functional>
+
+#include "GLStateCache.hpp"
+#include "Material.hpp"
+#include "Mesh.hpp"
+#include "Model.hpp"
+#include "Shader.hpp"
+#include "include_5568ke.hpp"
+
+namespace {
+constexpr int k_shaderBits = 10;
+constexpr int k_materialBits = 16;
+constexpr int k_vaoBits = 16;
+constexpr int k_depthBits = 20;
+
+constexpr int k_depthShift = 0;
+constexpr int k_vaoShift = k_depthShift + k_depthBits;
+constexpr int k_materialShift = k_vaoShift + k_vaoBits;
+constexpr int k_shaderShift = k_materialShift + k_materialBits;
+constexpr int k_passShift = k_shaderShift + k_shaderBits;
+
+constexpr std::uint64_t mask(int bits) { return (std::uint64_t{1} << bits) - 1; }
+
+// Ids past the field width wrap around, that only costs some extra state changes
+template <typename Map, typename Key>
+std::uint64_t getId(Map& ids, Key const& key, int bits)
+{
+	auto [it, inserted] = ids.try_emplace(key, ids.size());
+	return it->second & mask(bits);
+}
+} // namespace
+
+std::size_t RenderQueue::BatchKeyHash::operator()(BatchKey const& k) const noexcept
+{
+	std::size_t h = std::hash<void const*>{}(k.shader);
+	h = h * 31 + std::hash<void const*>{}(k.material);
+	h = h * 31 + k.vao;
+	h = h * 31 + k.indexOffset;
+	h = h * 31 + k.indexCount;
+	return h;
+}
+
+void RenderQueue::init()
+{
+	glGenBuffers(1, &instanceVbo_);
+
+	glGenBuffers(1, &jointBuffer_);
+	glGenTextures(1, &jointTexture_);
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	maxJointTexels_ = static_cast<std::size_t>(std::max(maxTexels, 0));
+}
+
+void RenderQueue::cleanup()
+{
+	if (instanceVbo_) {
+		glDeleteBuffers(1, &instanceVbo_);
+		instanceVbo_ = 0;
+		instanceVboCapacity_ = 0;
+	}
+	if (jointTexture_) {
+		glDeleteTextures(1, &jointTexture_);
+		jointTexture_ = 0;
+	}
+	if (jointBuffer_) {
+		glDeleteBuffers(1, &jointBuffer_);
+		jointBuffer_ = 0;
+		jointBufferCapacity_ = 0;
+	}
+}
+
+void RenderQueue::clear()
+{
+	items_.clear();
+	order_.clear();
+	batches_.clear();
+	batchIndex_.clear();
+	instanceMatrices_.clear();
+	jointPalette_.clear();
+	jointOffsets_.clear();
+	jointCount_ = 0;
+	shaderIds_.clear();
+	materialIds_.clear();
+	vaoIds_.clear();
+}
+
+void RenderQueue::addModel(Model const& model, glm::mat4 const& modelMatrix, Shader const& shader, bool skinned, float depth, int lod)
+{
+	// The palette holds at least 16384 matrices, a skinned model past that is left out of the frame
+	std::uint32_t jointOffset = 0;
+	if (skinned && !addJoints_(model, jointOffset))
+		return;
+
+	for (std::size_t i = 0; i < model.asset->meshes.size(); ++i) {
+		Mesh const& mesh = model.asset->meshes[i];
+
+		// Meshes attached to a node are placed by the node matrix
+		glm::mat4 transform = modelMatrix;
+		if (i < model.asset->meshNodeIndices.size()) {
+			int nodeIndex = model.asset->meshNodeIndices[i];
+			if (nodeIndex >= 0 && static_cast<std::size_t>(nodeIndex) < model.globalMatrices.size())
+				transform = modelMatrix * model.globalMatrices[nodeIndex];
+		}
+
+		for (auto const& prim : mesh.primitives) {
+			DrawItem item{&shader, prim.material, jointOffset, mesh.getVAO(), prim.indexCount, prim.indexOffset, mesh.getIndexType(), prim.doubleSided, skinned,
+										skinned && mesh.getLayout() == VertexLayout::Static, transform};
+			if (lod > 0 && !prim.lods.empty()) {
+				Primitive::Lod const& range = prim.lods[std::min<std::size_t>(lod, prim.lods.size()) - 1];
+				item.indexOffset = range.indexOffset;
+				item.indexCount = range.indexCount;
+			}
+
+			// Each skinned copy has its own joint palette
+			if (skinned) {
+				pushItem_(item, depth);
+				continue;
+			}
+
+			BatchKey key{&shader, prim.material, item.vao, item.indexOffset, item.indexCount};
+			auto [it, inserted] = batchIndex_.try_emplace(key, batches_.size());
+			if (inserted)
+				batches_.push_back(Batch{item, depth, {}});
+
+			Batch& batch = batches_[it->second];
+			batch.depth = std::min(batch.depth, depth);
+			batch.transforms.push_back(transform);
+		}
+	}
+}
+
+void RenderQueue::sort()
+{
+	for (Batch& batch : batches_) {
+		DrawItem item = batch.item;
+
+		if (!instancedShader || batch.transforms.size() < k_minInstances) {
+			for (auto const& transform : batch.transforms) {
+				item.transform = transform;
+				pushItem_(item, batch.depth);
+			}
+			continue;
+		}
+
+		item.shader = instancedShader;
+		item.firstInstance = static_cast<std::uint32_t>(instanceMatrices_.size());
+		item.instanceCount = static_cast<std::uint32_t>(batch.transforms.size());
+		instanceMatrices_.insert(instanceMatrices_.end(), batch.transforms.begin(), batch.transforms.end());
+		pushItem_(item, batch.depth);
+	}
+
+	std::sort(order_.begin(), order_.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+}
+
+RenderQueue::Stats RenderQueue::submit()
+{
+	Stats stats;
+
+	uploadInstances_();
+	uploadJointPalette_();
+	stats.joints = jointCount_;
+	stats.jointBytes = static_cast<int>(jointPalette_.size() * sizeof(glm::vec4));
+	stats.jointMatrixBytes = jointCount_ * static_cast<int>(sizeof(glm::mat4));
+
+	// Returns whether the state has to change, and counts it
+	auto changed = [&stats](bool differs) {
+		if (differs)
+			stats.stateChanges++;
+		else
+			stats.stateChangesAvoided++;
+		return differs;
+	};
+
+	Shader const* shader = nullptr;
+	Material const* material = nullptr;
+	std::uint32_t jointOffset = 0;
+	unsigned int vao = 0;
+	bool cullDisabled = false;
+	Shader::Uniform<glm::mat4> modelUniform;
+	Shader::Uniform<int> jointOffsetUniform;
+
+	for (auto const& [key, index] : order_) {
+		DrawItem const& item = items_[index];
+
+		if (changed(item.shader != shader)) {
+			shader = item.shader;
+			shader->bind();
+			// The instanced shader reads the model matrix from the instance buffer
+			modelUniform = item.instanceCount > 1 ? Shader::Uniform<glm::mat4>{} : shader->getUniform<glm::mat4>("model");
+			if (item.skinned) {
+				shader->sendBool("enableSkinning", true);
+				shader->sendSampler("jointPalette", k_jointPaletteUnit);
+				jointOffsetUniform = shader->getUniform<int>("jointOffset");
+			}
+
+			// Sampler uniforms and the joint offset belong to the program
+			material = nullptr;
+			jointOffset = ~0u;
+		}
+
+		if (item.material && changed(item.material != material)) {
+			material = item.material;
+			material->bind(*shader);
+		}
+
+		// The index buffer is part of the VAO state
+		if (changed(item.vao != vao)) {
+			vao = item.vao;
+			glBindVertexArray(vao);
+		}
+
+		if (item.skinned && changed(item.jointOffset != jointOffset)) {
+			jointOffset = item.jointOffset;
+			shader->send(jointOffsetUniform, static_cast<int>(jointOffset));
+		}
+
+		// The generic attribute value is context state, not VAO state, so it is set right before the draw that reads it
+		if (item.unweighted)
+			glVertexAttrib4f(4, 0.0f, 0.0f, 0.0f, 0.0f);
+
+		if (changed(item.doubleSided != cullDisabled)) {
+			cullDisabled = item.doubleSided;
+			if (cullDisabled)
+				glDisable(GL_CULL_FACE);
+			else
+				glEnable(GL_CULL_FACE);
+		}
+
+		std::size_t indexSize = item.indexType == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+		void* indices = (void*)(item.indexOffset * indexSize);
+		if (item.instanceCount > 1) {
+			bindInstanceAttributes_(item.firstInstance);
+			glDrawElementsInstanced(GL_TRIANGLES, item.indexCount, item.indexType, indices, item.instanceCount);
+			stats.instancedDrawCalls++;
+			stats.instances += item.instanceCount;
+		}
+		else {
+			shader->send(modelUniform, item.transform);
+			glDrawElements(GL_TRIANGLES, item.indexCount, item.indexType, indices);
+		}
+		stats.drawCalls++;
+		stats.triangles += static_cast<int>(item.indexCount / 3 * item.instanceCount);
+	}
+
+	if (cullDisabled)
+		glEnable(GL_CULL_FACE);
+	glBindVertexArray(0);
+
+	return stats;
+}
+
+void RenderQueue::pushItem_(DrawItem const& item, float depth)
+{
+	order_.emplace_back(makeKey_(item, depth), static_cast<std::uint32_t>(items_.size()));
+	items_.push_back(item);
+}
+
+void RenderQueue::uploadInstances_()
+{
+	if (instanceMatrices_.empty() || !instanceVbo_)
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+
+	// Grow geometrically, otherwise orphan the old storage so the driver doesn't wait for last frame's draws
+	if (instanceMatrices_.size() > instanceVboCapacity_)
+		instanceVboCapacity_ = std::max(instanceMatrices_.size(), instanceVboCapacity_ * 2);
+	glBufferData(GL_ARRAY_BUFFER, instanceVboCapacity_ * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instanceMatrices_.size() * sizeof(glm::mat4), instanceMatrices_.data());
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void RenderQueue::uploadJointPalette_()
+{
+	if (jointPalette_.empty() || !jointBuffer_)
+		return;
+
+	// Same growth and orphaning as the instance buffer
+	glBindBuffer(GL_TEXTURE_BUFFER, jointBuffer_);
+	bool grown = jointPalette_.size() > jointBufferCapacity_;
+	if (grown)
+		jointBufferCapacity_ = std::min(std::max(jointPalette_.size(), jointBufferCapacity_ * 2), maxJointTexels_);
+	glBufferData(GL_TEXTURE_BUFFER, jointBufferCapacity_ * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, jointPalette_.size() * sizeof(glm::vec4), jointPalette_.data());
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	// The texture views the buffer storage, it only has to be attached again when the size changes
+	GLStateCache::getInstance().activeTexture(k_jointPaletteUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, jointTexture_);
+	if (grown)
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, jointBuffer_);
+}
+
+bool RenderQueue::addJoints_(Model const& model, std::uint32_t& offset)
+{
+	auto it = jointOffsets_.find(&model);
+	if (it == jointOffsets_.end()) {
+		// The columns of a matrix or the real and dual part of a dual quaternion, one texel each
+		bool dualQuat = !model.jointDualQuaternions.empty();
+		auto const* texels = dualQuat ? reinterpret_cast<glm::vec4 const*>(model.jointDualQuaternions.data())
+																	: reinterpret_cast<glm::vec4 const*>(model.jointMatrices.data());
+		std::size_t texelCount = dualQuat ? model.jointDualQuaternions.size() * 2 : model.jointMatrices.size() * 4;
+		if (jointPalette_.size() + texelCount > maxJointTexels_)
+			return false;
+
+		it = jointOffsets_.emplace(&model, static_cast<std::uint32_t>(jointPalette_.size())).first;
+		jointPalette_.insert(jointPalette_.end(), texels, texels + texelCount);
+		jointCount_ += static_cast<int>(model.jointMatrices.size());
+	}
+	offset = it->second;
+	return true;
+}
+
+void RenderQueue::bindInstanceAttributes_(std::uint32_t firstInstance) const
+{
+	// Stored in the bound VAO, a mat4 attribute takes four vec4 locations
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+	std::size_t offset = firstInstance * sizeof(glm::mat4);
+	for (unsigned int column = 0; column < 4; ++column) {
+		unsigned int location = k_instanceMatrixLocation + column;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(location, 1);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+std::uint64_t RenderQueue::makeKey_(DrawItem const& item, float depth)
+{
+	std::uint64_t pass = item.doubleSided ? PASS_DOUBLE_SIDED : PASS_OPAQUE;
+	std::uint64_t shaderId = getId(shaderIds_, static_cast<void const*>(item.shader), k_shaderBits);
+	std::uint64_t materialId = getId(materialIds_, static_cast<void const*>(item.material), k_materialBits);
+	std::uint64_t vaoId = getId(vaoIds_, item.vao, k_vaoBits);
+
+	// Front to back, so nearer opaque geometry fills the depth buffer first
+	float normalizedDepth = std::clamp(depth / k_maxSortDepth, 0.0f, 1.0f);
+	std::uint64_t depthBucket = static_cast<std::uint64_t>(normalizedDepth * static_cast<float>(mask(k_depthBits)));
+
+	return (pass << k_passShift) | (shaderId << k_shaderShift) | (materialId << k_materialShift) | (vaoId << k_vaoShift) | (depthBucket << k_depthShift);
+}
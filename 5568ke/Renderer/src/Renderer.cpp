@@ -2,15 +2,32 @@
 
 #include "Renderer.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "BlinnPhongMaterial.hpp"
+#include "GLStateCache.hpp"
 #include "Model.hpp"
 #include "Scene.hpp"
 #include "Shader.hpp"
 #include "include_5568ke.hpp"
 
+namespace {
+// Mirrors the std140 FrameData block declared in assets/shaders, vec3s are padded to vec4
+struct FrameData {
+	glm::mat4 view;
+	glm::mat4 proj;
+	glm::vec4 viewPos;
+	glm::ivec4 lightCount; // x only
+	glm::vec4 lightPositions[Renderer::k_maxLights];
+	glm::vec4 lightColors[Renderer::k_maxLights]; // rgb already multiplied by the intensity
+};
+static_assert(sizeof(FrameData) == 2 * 64 + 2 * 16 + 2 * 16 * Renderer::k_maxLights, "FrameData must match the std140 layout");
+} // namespace
+
 Renderer& Renderer::getInstance()
 {
 	static Renderer instance;
@@ -19,6 +36,23 @@ Renderer& Renderer::getInstance()
 
 void Renderer::init()
 {
+	// Per-frame uniform buffer, stays bound to its binding point for the whole run
+	glGenBuffers(1, &frameDataUbo_);
+	glBindBuffer(GL_UNIFORM_BUFFER, frameDataUbo_);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, Shader::k_frameDataBinding, frameDataUbo_);
+
+	// White 1x1 texture for materials without any texture
+	unsigned char whitePixel[4] = {255, 255, 255, 255};
+	glGenTextures(1, &defaultTexture_);
+	glBindTexture(GL_TEXTURE_2D, defaultTexture_);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	BlinnPhongMaterial::fallbackTexture = defaultTexture_;
+
 	// Create default shaders
 	auto blinnPhongShader = std::make_unique<Shader>();
 	blinnPhongShader->resetShaderPath("assets/shaders/blinn.vert", "assets/shaders/blinn.frag");
@@ -29,9 +63,22 @@ void Renderer::init()
 	skinnedShader->resetShaderPath("assets/shaders/skinned.vert", "assets/shaders/blinn.frag");
 	shaders_["skinned"] = std::move(skinnedShader);
 
+	// Dual quaternion skinning for the models that turn it on
+	auto skinnedDqsShader = std::make_unique<Shader>();
+	skinnedDqsShader->resetShaderPath("assets/shaders/skinned_dqs.vert", "assets/shaders/blinn.frag");
+	shaders_["skinned_dqs"] = std::move(skinnedDqsShader);
+
+	// Instanced variant of blinn for repeated static primitives
+	auto instancedShader = std::make_unique<Shader>();
+	instancedShader->resetShaderPath("assets/shaders/blinn_instanced.vert", "assets/shaders/blinn.frag");
+	shaders_["blinn_instanced"] = std::move(instancedShader);
+	renderQueue_.init();
+
 	// Set default main shader
 	mainShader_ = shaders_["blinn"];
 	skinnedShader_ = shaders_["skinned"];
+	skinnedDqsShader_ = shaders_["skinned_dqs"];
+	instancedShader_ = shaders_["blinn_instanced"];
 
 	// Initialize skeleton visualizer
 	skeletonVisualizerRef.init();
@@ -72,12 +119,18 @@ void Renderer::beginFrame(int w, int h, glm::vec3 const& c)
 
 	// Reset frame stats
 	currentFrameStats_ = FrameStats();
+
+	// Texture uploads and the ImGui backend bind GL state directly between frames
+	GLStateCache::getInstance().invalidate();
+	GLStateCache::getInstance().resetStats();
 }
 
 void Renderer::drawScene(Scene const& scene)
 {
+	updateFrameData_(scene);
+
 	if (showSkybox)
-		skyboxVisualizerRef.draw(scene);
+		skyboxVisualizerRef.draw();
 
 	if (showModels)
 		drawModels_(scene);
@@ -86,7 +139,9 @@ void Renderer::drawScene(Scene const& scene)
 		lightVisualizerRef.draw(scene);
 
 	if (showBBox)
-		boundingBoxVisualizerRef.draw(scene);
+		boundingBoxVisualizerRef.draw(scene, frustum_);
+
+	currentFrameStats_.redundantGLCallsSkipped = GLStateCache::getInstance().getStats().skipped;
 }
 
 void Renderer::drawModels_(Scene const& scene)
@@ -94,88 +149,114 @@ void Renderer::drawModels_(Scene const& scene)
 	if (!mainShader_)
 		return;
 
-	// Bind the main shader
-	mainShader_->bind();
+	// Gather the entities inside the view frustum through the scene BVH
+	visibleObjects_.clear();
+	scene.queryFrustum(frustum_, [this](GameObject& gameObject) {
+		if (gameObject.visible)
+			visibleObjects_.push_back(&gameObject);
+		return true;
+	});
 
-	// Set camera-related uniforms
-	mainShader_->sendMat4("view", scene.cam.view);
-	mainShader_->sendMat4("proj", scene.cam.proj);
+	currentFrameStats_.culledEntities = scene.getVisibleIndexedCount() - static_cast<int>(visibleObjects_.size());
 
-	// Setup lighting
-	setupLighting_(scene, mainShader_);
-
-	// If we have a skinned shader, set up its uniforms too
-	if (skinnedShader_) {
-		skinnedShader_->bind();
-		skinnedShader_->sendMat4("view", scene.cam.view);
-		skinnedShader_->sendMat4("proj", scene.cam.proj);
-		setupLighting_(scene, skinnedShader_);
-	}
-
-	// Draw all visible entities
-	for (auto const& goPtr : scene.gameObjects) {
-		if (!goPtr || !goPtr->visible || !goPtr->getModel())
-			continue;
-
-		GameObject& gameObject = *goPtr;
-		if (showWireFrame) {
-			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		}
-		else {
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		}
+	// Queue the primitives of every visible entity, camera and lights come from the FrameData block
+	renderQueue_.clear();
+	renderQueue_.instancedShader = useInstancing ? instancedShader_.get() : nullptr;
+	for (GameObject* gameObject : visibleObjects_) {
+		Model const& model = *gameObject->getModel();
 
 		// Choose shader based on if the model has joint matrices
-		Shader const* shaderToUse = mainShader_.get();
-
-		if (skinnedShader_ && !gameObject.getModel()->jointMatrices.empty() && gameObject.getModel()->animations.size() > 0)
-			shaderToUse = skinnedShader_.get();
-
-		shaderToUse->bind();																									// Bind the appropriate shader
-		gameObject.getModel()->draw(*shaderToUse, gameObject.getTransform()); // Draw the model with the scaled model matrix
-
-		if (skeletonVisualizerRef.hasSkeletonData(gameObject.getModel())) {
+		bool skinned = skinnedShader_ && !model.jointMatrices.empty() && model.asset->animations.size() > 0;
+		// The RenderQueue uploads the dual quaternions whenever the model has them
+		bool dualQuat = skinned && skinnedDqsShader_ && !model.jointDualQuaternions.empty();
+		Shader const& shaderToUse = dualQuat ? *skinnedDqsShader_ : skinned ? *skinnedShader_ : *mainShader_;
+
+		float depth = glm::length(BBoxUtil::getBBoxCenter(gameObject->worldBBox) - scene.cam.pos);
+
+		// Bounding sphere radius over the half screen height at that distance
+		int lod = 0;
+		if (useLods) {
+			float radius = 0.5f * glm::length(gameObject->worldBBox.max - gameObject->worldBBox.min);
+			float coverage = depth > radius ? radius * scene.cam.proj[1][1] / depth : 1.0f;
+			while (lod < static_cast<int>(std::size(k_lodCoverage)) && coverage < k_lodCoverage[lod] * lodBias)
+				lod++;
+		}
+		currentFrameStats_.lodEntities[lod]++;
 
-			// Draw skeleton if enabled
-			if (showSkeletons) {
-				// Draw debug visualization
-				skeletonVisualizerRef.draw(gameObject, scene.cam);
+		renderQueue_.addModel(model, gameObject->getTransform(), shaderToUse, skinned, depth, lod);
+	}
 
-				// Rebind main shader after drawing lines
-				mainShader_->bind();
-			}
+	glPolygonMode(GL_FRONT_AND_BACK, showWireFrame ? GL_LINE : GL_FILL);
+
+	renderQueue_.sort();
+	RenderQueue::Stats queueStats = renderQueue_.submit();
+
+	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	// Update stats
+	currentFrameStats_.drawCalls += queueStats.drawCalls;
+	currentFrameStats_.instancedDrawCalls += queueStats.instancedDrawCalls;
+	currentFrameStats_.instances += queueStats.instances;
+	currentFrameStats_.stateChanges += queueStats.stateChanges;
+	currentFrameStats_.stateChangesAvoided += queueStats.stateChangesAvoided;
+	currentFrameStats_.triangles += queueStats.triangles;
+	currentFrameStats_.joints += queueStats.joints;
+	currentFrameStats_.jointBytes += queueStats.jointBytes;
+	currentFrameStats_.jointMatrixBytes += queueStats.jointMatrixBytes;
+	currentFrameStats_.visibleEntities = static_cast<int>(visibleObjects_.size());
+
+	// Draw skeletons on top of the models if enabled
+	if (showSkeletons) {
+		for (GameObject* gameObject : visibleObjects_) {
+			if (skeletonVisualizerRef.hasSkeletonData(gameObject->getModel()))
+				skeletonVisualizerRef.draw(*gameObject);
 		}
-
-		// Update stats
-		currentFrameStats_.drawCalls++;
-		currentFrameStats_.visibleEntities++;
 	}
 }
 
-void Renderer::setupLighting_(Scene const& scene, std::shared_ptr<Shader> const& shader)
+void Renderer::updateFrameData_(Scene const& scene)
 {
-	if (!shader)
-		return;
-
-	// Set light positions and properties
-	// This implementation assumes a simple lighting model like in the original code
-	if (!scene.lights.empty()) {
-		shader->sendVec3("lightPos", scene.lights[0].position);
-		// shader->sendVec3("lightColor", scene.lights[0].color);
-		// shader->sendFloat("lightIntensity", scene.lights[0].intensity);
+	FrameData data{};
+	data.view = scene.cam.view;
+	data.proj = scene.cam.proj;
+	data.viewPos = glm::vec4(scene.cam.pos, 1.0f);
+
+	frustum_ = FrustumUtil::extractFrustum(scene.cam.proj * scene.cam.view);
+
+	int lightCount = static_cast<int>(std::min<std::size_t>(scene.lights.size(), k_maxLights));
+	data.lightCount.x = lightCount;
+	for (int i = 0; i < lightCount; ++i) {
+		Light const& light = scene.lights[i];
+		data.lightPositions[i] = glm::vec4(light.position, 1.0f);
+		data.lightColors[i] = glm::vec4(light.color * light.intensity, 1.0f);
 	}
 
-	shader->sendVec3("viewPos", scene.cam.pos);
+	glBindBuffer(GL_UNIFORM_BUFFER, frameDataUbo_);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 void Renderer::endFrame()
 {
 	glBindVertexArray(0);
-	glUseProgram(0);
+	GLStateCache::getInstance().useProgram(0);
 }
 
 void Renderer::cleanup()
 {
+	renderQueue_.cleanup();
+
+	if (frameDataUbo_) {
+		glDeleteBuffers(1, &frameDataUbo_);
+		frameDataUbo_ = 0;
+	}
+
+	if (defaultTexture_) {
+		glDeleteTextures(1, &defaultTexture_);
+		defaultTexture_ = 0;
+		BlinnPhongMaterial::fallbackTexture = 0;
+	}
+
 	// Clean up skeleton visualizer
 	skeletonVisualizerRef.cleanup();
 	lightVisualizerRef.cleanup();
@@ -62,7 +62,7 @@ bool SkeletonVisualizer::hasSkeletonData(std::shared_ptr<Model> model) const
 
 	// A model has skeleton data if it has animations
 	// Even if it has no joint matrices yet (they might be created when animation plays)
-	return !model->animations.empty();
+	return !model->asset->animations.empty();
 }
 
 void SkeletonVisualizer::generateSkeletonData(std::shared_ptr<Model> model)
@@ -90,7 +90,7 @@ void SkeletonVisualizer::generateSkeletonData(std::shared_ptr<Model> model)
 
 	// Process the node hierarchy recursively starting from the root
 	float nodePosScale = 0.005f;
-	processNodeTreePositionsRecursive(model->rootNode, skeletonData.vertices, skeletonData.colors, nodePosScale);
+	processNodeTreePositionsRecursive(*model, model->rootNode, skeletonData.vertices, skeletonData.colors, nodePosScale);
 
 	// std::cout << "[SkeletonVisualizer] Generated " << skeletonData.vertices.size() << " vertices for skeleton lines" << std::endl;
 
@@ -98,21 +98,21 @@ void SkeletonVisualizer::generateSkeletonData(std::shared_ptr<Model> model)
 	skeletonCache[model] = skeletonData;
 }
 
-void SkeletonVisualizer::processNodeTreePositionsRecursive(std::shared_ptr<Node> node, std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& colors,
-																													 float nodePosScale)
+void SkeletonVisualizer::processNodeTreePositionsRecursive(Model const& model, std::shared_ptr<Node> node, std::vector<glm::vec3>& vertices,
+																													 std::vector<glm::vec3>& colors, float nodePosScale)
 {
 	if (!node)
 		return;
 
 	// Get node position
-	glm::mat4 nodeMatrix = node->getNodeMatrix();
+	glm::mat4 const& nodeMatrix = model.getNodeMatrix(node->nodeNum);
 	glm::vec3 nodePos = glm::vec3(nodeMatrix[3]);
 
 	// Skip nodes with zero position (might be invalid)
 	if (glm::length(nodePos) < 0.001f) {
 		// Process children anyway
 		for (auto& child : node->children) {
-			processNodeTreePositionsRecursive(child, vertices, colors, nodePosScale);
+			processNodeTreePositionsRecursive(model, child, vertices, colors, nodePosScale);
 		}
 		return;
 	}
@@ -148,7 +148,7 @@ void SkeletonVisualizer::processNodeTreePositionsRecursive(std::shared_ptr<Node>
 		if (!child)
 			continue;
 
-		glm::mat4 childMatrix = child->getNodeMatrix();
+		glm::mat4 const& childMatrix = model.getNodeMatrix(child->nodeNum);
 		glm::vec3 childPos = glm::vec3(childMatrix[3]);
 
 		// Only draw connections to nodes with valid positions
@@ -169,11 +169,11 @@ void SkeletonVisualizer::processNodeTreePositionsRecursive(std::shared_ptr<Node>
 
 	// Process children recursively
 	for (auto& child : node->children) {
-		processNodeTreePositionsRecursive(child, vertices, colors, nodePosScale);
+		processNodeTreePositionsRecursive(model, child, vertices, colors, nodePosScale);
 	}
 }
 
-void SkeletonVisualizer::draw(GameObject const& gameObject, Camera const& cam)
+void SkeletonVisualizer::draw(GameObject const& gameObject)
 {
 	auto model = gameObject.getModel();
 
@@ -196,7 +196,7 @@ void SkeletonVisualizer::draw(GameObject const& gameObject, Camera const& cam)
 	if (model->rootNode) {
 		// Use the same scale factor for skeleton as for the model
 		float nodePosScale = 1.0f; // This will be applied with the model matrix
-		processNodeTreePositionsRecursive(model->rootNode, vertices, colors, nodePosScale);
+		processNodeTreePositionsRecursive(*model, model->rootNode, vertices, colors, nodePosScale);
 	}
 
 	// Skip if no vertices
@@ -224,8 +224,6 @@ void SkeletonVisualizer::draw(GameObject const& gameObject, Camera const& cam)
 
 	// Bind shader and set uniforms
 	skeletonShader->bind();
-	skeletonShader->sendMat4("view", cam.view);
-	skeletonShader->sendMat4("proj", cam.proj);
 	skeletonShader->sendMat4("model", gameObject.getTransform());
 
 	// Draw lines with wider lines for better visibility
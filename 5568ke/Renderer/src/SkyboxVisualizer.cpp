@@ -8,6 +8,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "GLStateCache.hpp"
 #include "Model.hpp"
 #include "ModelRegistry.hpp"
 #include "Scene.hpp"
@@ -126,7 +127,7 @@ bool SkyboxVisualizer::loadSkyboxFromCubemap(std::string const& directory)
 	return true;
 }
 
-void SkyboxVisualizer::draw(Scene const& scene)
+void SkyboxVisualizer::draw()
 {
 	if (skyboxType == SkyboxType::NONE) {
 		return; // Nothing to draw
@@ -159,11 +160,6 @@ void SkyboxVisualizer::draw(Scene const& scene)
 
 		// Create a scaled model matrix to make the skybox large enough and center it on the camera
 		glm::mat4 skyboxModelMat = glm::scale(glm::mat4(1.0f), glm::vec3(50.0f)); // Make it larger
-
-		// Remove translation from view matrix to keep skybox centered on camera
-		glm::mat4 skyboxView = glm::mat4(glm::mat3(scene.cam.view)); // Remove translation
-		skyboxShader->sendMat4("view", skyboxView);
-		skyboxShader->sendMat4("proj", scene.cam.proj);
 		skyboxShader->sendMat4("model", skyboxModelMat);
 
 		// Draw the skybox model
@@ -198,13 +194,8 @@ void SkyboxVisualizer::draw(Scene const& scene)
 		// Use cubemap shader
 		cubemapShader->bind();
 
-		// Remove translation from view matrix to keep skybox centered on camera
-		glm::mat4 skyboxView = glm::mat4(glm::mat3(scene.cam.view)); // Remove translation
-		cubemapShader->sendMat4("view", skyboxView);
-		cubemapShader->sendMat4("proj", scene.cam.proj);
-
 		// Bind the cubemap texture
-		glActiveTexture(GL_TEXTURE0);
+		GLStateCache::getInstance().activeTexture(0);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
 		cubemapShader->sendInt("skybox", 0);
 
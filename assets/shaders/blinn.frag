@@ -3,7 +3,16 @@ out vec4 FragColor;
 in VS_OUT{vec3 Pos;vec3 N;vec2 UV;} fs;
 uniform sampler2D tex0;   // base
 uniform sampler2D tex1;   // overlay, may be all‑transparent
-uniform vec3 lightPos, viewPos;
+// Per-frame data shared by every shader, keep in sync with FrameData in Renderer.cpp
+const int MAX_LIGHTS = 10;
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+    ivec4 lightCount;
+    vec4 lightPositions[MAX_LIGHTS];
+    vec4 lightColors[MAX_LIGHTS];
+};
 
 void main()
 {
@@ -24,17 +33,21 @@ void main()
     
     // Prepare lighting variables
     vec3 N = normalize(fs.N);
-    vec3 L = normalize(lightPos - fs.Pos);
-    vec3 V = normalize(viewPos - fs.Pos);
-    vec3 H = normalize(L + V);
+    vec3 V = normalize(viewPos.xyz - fs.Pos);
     
-    // Calculate lighting components
+    // Accumulate every light, colors already include the intensity
     float ambient = 0.2;
-    float diffuse = max(dot(N, L), 0.0) * 0.8;
-    float specular = pow(max(dot(N, H), 0.0), 32.0) * 0.4;
+    vec3 diffuse = vec3(0.0);
+    vec3 specular = vec3(0.0);
+    for (int i = 0; i < min(lightCount.x, MAX_LIGHTS); i++) {
+        vec3 L = normalize(lightPositions[i].xyz - fs.Pos);
+        vec3 H = normalize(L + V);
+        diffuse += lightColors[i].rgb * max(dot(N, L), 0.0) * 0.8;
+        specular += lightColors[i].rgb * pow(max(dot(N, H), 0.0), 32.0) * 0.4;
+    }
     
     // Apply lighting to texture color
-    vec3 finalColor = texColor.rgb * (ambient + diffuse) + vec3(1.0) * specular;
+    vec3 finalColor = texColor.rgb * (ambient + diffuse) + specular;
     
     // Output final color
     FragColor = vec4(finalColor, 1.0);
@@ -1,16 +1,33 @@
 #version 330 core
 
 layout(location=0) in vec3 aPos;
-layout(location=1) in vec3 aNormal;
+layout(location=1) in vec2 aNormalOct; // Octahedral encoded
 layout(location=2) in vec2 aUV;
 
-uniform mat4 model,view,proj;
+uniform mat4 model;
+// Per-frame data shared by every shader, keep in sync with FrameData in Renderer.cpp
+const int MAX_LIGHTS = 10;
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+    ivec4 lightCount;
+    vec4 lightPositions[MAX_LIGHTS];
+    vec4 lightColors[MAX_LIGHTS];
+};
 out VS_OUT{vec3 Pos;vec3 N;vec2 UV;} vs;
 
+// Octahedral normal of the vertex buffer, keep in sync with encodeNormal in Mesh.cpp
+vec3 decodeNormal(vec2 e){
+    vec3 n = vec3(e, 1.0-abs(e.x)-abs(e.y));
+    if(n.z < 0.0) n.xy = (1.0-abs(n.yx))*vec2(n.x>=0.0?1.0:-1.0, n.y>=0.0?1.0:-1.0);
+    return normalize(n);
+}
+
 void main(){
     vec4 world = model*vec4(aPos,1);
     vs.Pos = world.xyz;
-    vs.N   = mat3(transpose(inverse(model)))*aNormal;
+    vs.N   = mat3(transpose(inverse(model)))*decodeNormal(aNormalOct);
     vs.UV  = aUV;
     gl_Position = proj*view*world;
 }
@@ -2,8 +2,16 @@
 layout(location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+// Per-frame data shared by every shader, keep in sync with FrameData in Renderer.cpp
+const int MAX_LIGHTS = 10;
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+    ivec4 lightCount;
+    vec4 lightPositions[MAX_LIGHTS];
+    vec4 lightColors[MAX_LIGHTS];
+};
 
 void main() {
     gl_Position = proj * view * model * vec4(aPos, 1.0);
@@ -4,8 +4,16 @@ layout(location=0) in vec3 aPos;
 layout(location=1) in vec3 aColor;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+// Per-frame data shared by every shader, keep in sync with FrameData in Renderer.cpp
+const int MAX_LIGHTS = 10;
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+    ivec4 lightCount;
+    vec4 lightPositions[MAX_LIGHTS];
+    vec4 lightColors[MAX_LIGHTS];
+};
 
 out vec3 fragColor;
 
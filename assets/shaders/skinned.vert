@@ -1,14 +1,25 @@
 #version 330 core
 
 layout(location=0) in vec3 aPos;
-layout(location=1) in vec3 aNormal;
+layout(location=1) in vec2 aNormalOct; // Octahedral encoded
 layout(location=2) in vec2 aUV;
-layout(location=3) in ivec4 aBoneIds;
+layout(location=3) in uvec4 aBoneIds;
 layout(location=4) in vec4 aBoneWeights;
 
-const int MAX_BONES = 100;
-uniform mat4 model, view, proj;
-uniform mat4 jointMatrices[MAX_BONES];
+uniform mat4 model;
+// Per-frame data shared by every shader, keep in sync with FrameData in Renderer.cpp
+const int MAX_LIGHTS = 10;
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+    ivec4 lightCount;
+    vec4 lightPositions[MAX_LIGHTS];
+    vec4 lightColors[MAX_LIGHTS];
+};
+// Joint matrices of every skinned model this frame, four texels per matrix (see RenderQueue)
+uniform samplerBuffer jointPalette;
+uniform int jointOffset; // In texels
 uniform bool enableSkinning = true;
 
 out VS_OUT{
@@ -17,10 +28,24 @@ out VS_OUT{
     vec2 UV;
 } vs;
 
+// Octahedral normal of the vertex buffer, keep in sync with encodeNormal in Mesh.cpp
+vec3 decodeNormal(vec2 e){
+    vec3 n = vec3(e, 1.0-abs(e.x)-abs(e.y));
+    if(n.z < 0.0) n.xy = (1.0-abs(n.yx))*vec2(n.x>=0.0?1.0:-1.0, n.y>=0.0?1.0:-1.0);
+    return normalize(n);
+}
+
+mat4 getJointMatrix(int joint){
+    int base = jointOffset + joint * 4;
+    return mat4(texelFetch(jointPalette, base), texelFetch(jointPalette, base + 1),
+                texelFetch(jointPalette, base + 2), texelFetch(jointPalette, base + 3));
+}
+
 void main() {
     // First use original vertex position to be safe
     vec4 position = vec4(aPos, 1.0);
-    vec3 normal = aNormal;
+    vec3 bindNormal = decodeNormal(aNormalOct);
+    vec3 normal = bindNormal;
     
     // Apply skinning if enabled
     if (enableSkinning) {
@@ -34,14 +59,14 @@ void main() {
             float weight = aBoneWeights[i];
             if(weight > 0.0) {
                 totalWeight += weight;
-                int boneId = aBoneIds[i];
+                mat4 jointMatrix = getJointMatrix(int(aBoneIds[i]));
                 
                 // Transform position by bone matrix
-                position += weight * jointMatrices[boneId] * vec4(aPos, 1.0);
+                position += weight * jointMatrix * vec4(aPos, 1.0);
                 
                 // Transform normal by bone matrix (ignoring translation)
-                mat3 boneMat3 = mat3(jointMatrices[boneId]);
-                normal += weight * boneMat3 * aNormal;
+                mat3 boneMat3 = mat3(jointMatrix);
+                normal += weight * boneMat3 * bindNormal;
             }
         }
         
@@ -52,7 +77,7 @@ void main() {
         } else {
             // Fallback to original position
             position = vec4(aPos, 1.0);
-            normal = aNormal;
+            normal = bindNormal;
         }
     }
     
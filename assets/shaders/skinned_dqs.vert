@@ -0,0 +1,86 @@
+#version 330 core
+
+layout(location=0) in vec3 aPos;
+layout(location=1) in vec2 aNormalOct; // Octahedral encoded
+layout(location=2) in vec2 aUV;
+layout(location=3) in uvec4 aBoneIds;
+layout(location=4) in vec4 aBoneWeights;
+
+uniform mat4 model;
+// Per-frame data shared by every shader, keep in sync with FrameData in Renderer.cpp
+const int MAX_LIGHTS = 10;
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+    ivec4 lightCount;
+    vec4 lightPositions[MAX_LIGHTS];
+    vec4 lightColors[MAX_LIGHTS];
+};
+// Joint dual quaternions of every skinned model this frame, real then dual part (see RenderQueue)
+uniform samplerBuffer jointPalette;
+uniform int jointOffset; // In texels
+uniform bool enableSkinning = true;
+
+out VS_OUT{
+    vec3 Pos;
+    vec3 N;
+    vec2 UV;
+} vs;
+
+// Octahedral normal of the vertex buffer, keep in sync with encodeNormal in Mesh.cpp
+vec3 decodeNormal(vec2 e){
+    vec3 n = vec3(e, 1.0-abs(e.x)-abs(e.y));
+    if(n.z < 0.0) n.xy = (1.0-abs(n.yx))*vec2(n.x>=0.0?1.0:-1.0, n.y>=0.0?1.0:-1.0);
+    return normalize(n);
+}
+
+vec3 rotate(vec4 q, vec3 v){
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+    vec4 position = vec4(aPos, 1.0);
+    vec3 bindNormal = decodeNormal(aNormalOct);
+    vec3 normal = bindNormal;
+
+    // Blend the joint dual quaternions, keep in sync with getDualQuatSkinnedPosition in BoundingBox.cpp
+    if (enableSkinning) {
+        vec4 real = vec4(0.0);
+        vec4 dual = vec4(0.0);
+        vec4 pivot = vec4(0.0);
+
+        for(int i = 0; i < 4; i++) {
+            float weight = aBoneWeights[i];
+            if(weight > 0.0) {
+                int base = jointOffset + int(aBoneIds[i]) * 2;
+                vec4 jointReal = texelFetch(jointPalette, base);
+                vec4 jointDual = texelFetch(jointPalette, base + 1);
+
+                // q and -q are the same rotation, blend every joint in the hemisphere of the first one
+                if(pivot == vec4(0.0)) pivot = jointReal;
+                if(dot(pivot, jointReal) < 0.0) weight = -weight;
+
+                real += weight * jointReal;
+                dual += weight * jointDual;
+            }
+        }
+
+        float len = length(real);
+        if(len > 1e-6) {
+            real /= len;
+            dual /= len;
+            vec3 translation = 2.0 * (real.w * dual.xyz - dual.w * real.xyz + cross(real.xyz, dual.xyz));
+            position = vec4(rotate(real, aPos) + translation, 1.0);
+            normal = rotate(real, bindNormal);
+        }
+    }
+
+    // Apply model transformation
+    vec4 worldPos = model * position;
+    vs.Pos = worldPos.xyz;
+    vs.N = mat3(transpose(inverse(model))) * normal;
+    vs.UV = aUV;
+
+    gl_Position = proj * view * worldPos;
+}
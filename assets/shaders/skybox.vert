@@ -3,8 +3,16 @@ layout(location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 view;
-uniform mat4 proj;
+// Per-frame data shared by every shader, keep in sync with FrameData in Renderer.cpp
+const int MAX_LIGHTS = 10;
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 proj;
+    vec4 viewPos;
+    ivec4 lightCount;
+    vec4 lightPositions[MAX_LIGHTS];
+    vec4 lightColors[MAX_LIGHTS];
+};
 
 void main()
 {
@@ -12,6 +20,7 @@ void main()
     
     // Skybox should be infinitely far away, so we set z to w
     // after perspective division this ensures depth is always 1.0 (the maximum)
-    vec4 pos = proj * view * vec4(aPos, 1.0);
+    // Translation is removed from the view matrix to keep the skybox centered on the camera
+    vec4 pos = proj * mat4(mat3(view)) * vec4(aPos, 1.0);
     gl_Position = pos.xyww;
 }
\ No newline at end of file